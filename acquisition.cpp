@@ -0,0 +1,159 @@
+#include "acquisition.h"
+
+#include <algorithm>
+#include <cmath>
+
+//=============================================================================
+const char* acquireModeName(AcquireMode mode)
+{
+    static const char* names[] = {"Normal", "Average", "Equivalent time"};
+    static_assert(sizeof(names) / sizeof(names[0]) == AQ_Count, "one name per AcquireMode");
+
+    return mode < AQ_Count ? names[mode] : "";
+}
+//=============================================================================
+// captures that can be merged: same mode, range and time base
+static bool _sameGeometry(const DSOMetadata& a, const DSOMetadata& b)
+{
+    return a.mode == b.mode && a.range == b.range && a.window == b.window && a.samples == b.samples &&
+           a.samplingRate == b.samplingRate;
+}
+//=============================================================================
+CaptureAverage::CaptureAverage() : m_geometry{}, m_count(16), m_captures(0), m_weight(1.0f) {}
+//=============================================================================
+void CaptureAverage::setCount(uint32_t n)
+{
+    m_count    = n ? n : 1;
+    m_captures = 0;
+}
+//=============================================================================
+void CaptureAverage::begin(const DSOMetadata& metadata)
+{
+    if (!_sameGeometry(metadata, m_geometry) || m_avg.size() != metadata.samples)
+    {
+        m_geometry = metadata;
+        m_avg.assign(metadata.samples, 0.0f);
+        m_captures = 0;
+    }
+
+    m_captures++;
+    m_weight = 1.0f / (m_captures < m_count ? m_captures : m_count);
+}
+//=============================================================================
+float* CaptureAverage::block(float* x, uint32_t offset, uint32_t n)
+{
+    if (offset >= m_avg.size()) return x;
+    if (n > m_avg.size() - offset) n = uint32_t(m_avg.size() - offset);
+
+    float* avg = m_avg.data() + offset;
+    float w    = m_weight;
+
+    for (uint32_t i = 0; i < n; i++) avg[i] += (x[i] - avg[i]) * w;
+
+    return avg;
+}
+//=============================================================================
+EquivalentTime::EquivalentTime()
+    : m_geometry{}, m_factor(8), m_level(0.0f), m_rising(false), m_anchor(-1.0), m_captures(0), m_filled(0)
+{
+}
+//=============================================================================
+void EquivalentTime::setFactor(uint32_t factor)
+{
+    m_factor = factor ? factor : 1;
+    restart();
+}
+//=============================================================================
+void EquivalentTime::setTrigger(float level, bool rising)
+{
+    if (level == m_level && rising == m_rising) return;
+
+    m_level  = level;
+    m_rising = rising;
+    restart();
+}
+//=============================================================================
+void EquivalentTime::restart()
+{
+    std::fill(m_sum.begin(), m_sum.end(), 0.0);
+    std::fill(m_hits.begin(), m_hits.end(), 0u);
+    std::fill(m_out.begin(), m_out.end(), 0.0f);
+    m_anchor   = -1.0;
+    m_captures = 0;
+    m_filled   = 0;
+}
+//=============================================================================
+double EquivalentTime::_crossing(const float* x, uint32_t n, double near) const
+{
+    double best = -1.0;
+
+    for (uint32_t i = 0; i + 1 < n; i++)
+    {
+        float a = x[i] - m_level, b = x[i + 1] - m_level;
+        if (m_rising ? !(a < 0.0f && b >= 0.0f) : !(a > 0.0f && b <= 0.0f)) continue;
+
+        double f = i + a / (a - b);
+        if (near < 0.0) return f;  // the first one
+        if (best < 0.0 || fabs(f - near) < fabs(best - near)) best = f;
+    }
+
+    return best;
+}
+//=============================================================================
+bool EquivalentTime::add(const DSOMetadata& metadata, const float* x, uint32_t n)
+{
+    if (!_sameGeometry(metadata, m_geometry) || m_out.size() != (size_t)metadata.samples * m_factor)
+    {
+        m_geometry = metadata;
+        m_sum.assign((size_t)metadata.samples * m_factor, 0.0);
+        m_hits.assign(m_sum.size(), 0u);
+        m_out.assign(m_sum.size(), 0.0f);
+        restart();
+    }
+
+    double f = _crossing(x, n, m_anchor);
+    if (f < 0.0) return false;
+    if (m_anchor < 0.0) m_anchor = floor(f);
+
+    // sample j is at (j - f) sampling periods from the crossing
+    double shift = (m_anchor - f) * m_factor;
+    int64_t bins = (int64_t)m_sum.size();
+
+    for (uint32_t j = 0; j < n; j++)
+    {
+        int64_t bin = llround(j * (double)m_factor + shift);
+        if (bin < 0 || bin >= bins) continue;
+
+        m_filled += m_hits[bin] == 0;
+        m_sum[bin] += x[j];
+        m_hits[bin]++;
+    }
+
+    m_captures++;
+    _rebuild();
+    return true;
+}
+//=============================================================================
+void EquivalentTime::_rebuild()
+{
+    size_t n    = m_out.size();
+    size_t prev = n;  // last bin with hits
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!m_hits[i]) continue;
+
+        m_out[i] = float(m_sum[i] / m_hits[i]);
+
+        if (prev == n)
+            std::fill(m_out.begin(), m_out.begin() + i, m_out[i]);  // hold before the first one
+        else
+            for (size_t k = prev + 1; k < i; k++)
+                m_out[k] = m_out[prev] + (m_out[i] - m_out[prev]) * float(k - prev) / float(i - prev);
+
+        prev = i;
+    }
+
+    if (prev != n) std::fill(m_out.begin() + prev + 1, m_out.end(), m_out[prev]);
+}
+//=============================================================================
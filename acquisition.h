@@ -0,0 +1,102 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include "protocol.h"
+
+#include <cstdint>
+#include <vector>
+
+// Acquisition modes for repetitive signals, applied to the decoded captures
+enum AcquireMode : uint8_t
+{
+    AQ_Normal = 0,
+    AQ_Average,
+    AQ_EquivalentTime,
+    AQ_Count,
+};
+
+const char* acquireModeName(AcquireMode mode);
+
+// Running average of the captures, for noise reduction in the low ranges.
+// The first N captures are averaged with equal weights, after that every new
+// capture weighs 1/N (exponential average), so the trace keeps following slow
+// changes. The average restarts whenever the capture geometry changes, it is
+// the only time the storage is (re)allocated.
+class CaptureAverage
+{
+   public:
+    CaptureAverage();
+
+    void setCount(uint32_t n);
+    uint32_t count() const { return m_count; }
+
+    // a new capture described by `metadata`
+    void begin(const DSOMetadata& metadata);
+
+    // folds `n` samples starting at sample `offset` of the capture into the
+    // average, returns the averaged block (valid until the next call)
+    float* block(float* x, uint32_t offset, uint32_t n);
+
+    // the averaged trace, expected samples of the current geometry
+    const float* data() const { return m_avg.data(); }
+    uint32_t size() const { return (uint32_t)m_avg.size(); }
+
+    // captures in the average so far, up to count()
+    uint32_t averaged() const { return m_captures < m_count ? m_captures : m_count; }
+
+    void restart() { m_captures = 0; }
+
+   private:
+    std::vector<float> m_avg;
+    DSOMetadata m_geometry;
+    uint32_t m_count;
+    uint32_t m_captures;
+    float m_weight;  // of the capture in progress
+};
+
+// Equivalent-time sampling. Each capture is aligned on a trigger crossing
+// found in software, with sub-sample accuracy by linear interpolation, and
+// its samples are binned on a grid `factor` times finer than the sampling
+// period. Since the device trigger is not synchronous with its sample clock,
+// successive captures of a repetitive signal land on different bins and the
+// grid fills up, reconstructing the waveform at `factor` times the hardware
+// sampling rate. Empty bins are interpolated from their neighbours.
+class EquivalentTime
+{
+   public:
+    EquivalentTime();
+
+    void setFactor(uint32_t factor);
+    uint32_t factor() const { return m_factor; }
+
+    void setTrigger(float level, bool rising);
+
+    // adds a complete capture, false when it has no crossing to align on
+    bool add(const DSOMetadata& metadata, const float* x, uint32_t n);
+
+    // reconstruction, factor() points per capture sample
+    float* data() { return m_out.data(); }
+    uint32_t size() const { return (uint32_t)m_out.size(); }
+
+    uint32_t captures() const { return m_captures; }
+    uint32_t filled() const { return m_filled; }  // bins hit by at least one sample
+
+    void restart();
+
+   private:
+    std::vector<double> m_sum;
+    std::vector<uint32_t> m_hits;
+    std::vector<float> m_out;
+    DSOMetadata m_geometry;
+    uint32_t m_factor;
+    float m_level;
+    bool m_rising;
+    double m_anchor;  // sample index the crossing is aligned to, < 0 before the first capture
+    uint32_t m_captures, m_filled;
+
+    // fractional index of the crossing closest to `near`, < 0 when none
+    double _crossing(const float* x, uint32_t n, double near) const;
+    void _rebuild();
+};
+
+#endif  // ACQUISITION_H
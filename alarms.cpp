@@ -0,0 +1,207 @@
+#include "alarms.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+//=============================================================================
+const char* alarmSourceName(AlarmSource source)
+{
+    static const char* names[] = {"mm", "dso_mean", "dso_rms"};
+    static_assert(sizeof(names) / sizeof(names[0]) == AS_Count, "one name per AlarmSource");
+
+    return source < AS_Count ? names[source] : "";
+}
+//=============================================================================
+AlarmEngine::AlarmEngine() : m_raisedTotal(0) { memset(m_active, 0, sizeof(m_active)); }
+//=============================================================================
+bool AlarmEngine::parseRule(const std::string& line, AlarmRule& out, std::string* error)
+{
+    std::string text = line.substr(0, line.find('#'));
+    std::istringstream in(text);
+
+    std::string source, kind;
+    if (!(in >> source)) return false;  // blank or comment
+
+    auto fail = [&](const char* msg)
+    {
+        if (error) *error = msg;
+        return false;
+    };
+
+    AlarmRule r = {};
+    r.count     = 1;
+
+    int s = 0;
+    while (s < AS_Count && source != alarmSourceName((AlarmSource)s)) s++;
+    if (s == AS_Count) return fail("unknown source");
+    r.source = (AlarmSource)s;
+
+    if (!(in >> kind)) return fail("missing condition");
+
+    if (kind == "above")
+    {
+        r.kind = AK_Above;
+        if (!(in >> r.high)) return fail("missing limit");
+    }
+    else if (kind == "below")
+    {
+        r.kind = AK_Below;
+        if (!(in >> r.low)) return fail("missing limit");
+    }
+    else if (kind == "outside")
+    {
+        r.kind = AK_Outside;
+        if (!(in >> r.low >> r.high)) return fail("missing limits");
+        if (r.low > r.high) return fail("low limit above high limit");
+    }
+    else if (kind == "rate")
+    {
+        r.kind = AK_Rate;
+        if (!(in >> r.high)) return fail("missing limit");
+    }
+    else
+        return fail("unknown condition");
+
+    std::string opt;
+    while (in >> opt)
+    {
+        if (opt == "hyst")
+        {
+            if (!(in >> r.hysteresis) || r.hysteresis < 0.0f) return fail("bad hysteresis");
+        }
+        else if (opt == "count")
+        {
+            int n = 0;
+            if (!(in >> n) || n < 1 || n > UINT16_MAX) return fail("bad count");
+            r.count = (uint16_t)n;
+        }
+        else
+            return fail("unknown option");
+    }
+
+    // trimmed, for the events and the trace
+    size_t b = text.find_first_not_of(" \t");
+    size_t e = text.find_last_not_of(" \t\r\n");
+    r.text   = text.substr(b, e - b + 1);
+
+    out = r;
+    return true;
+}
+//=============================================================================
+int AlarmEngine::load(const std::string& path, std::vector<std::string>* errors)
+{
+    std::ifstream f(path);
+    if (!f)
+    {
+        if (errors) errors->push_back(path + ": can't open");
+        return 0;
+    }
+
+    int loaded = 0, n = 0;
+    std::string line;
+    while (std::getline(f, line))
+    {
+        n++;
+
+        AlarmRule r;
+        std::string error;
+        if (parseRule(line, r, &error))
+        {
+            if (addRule(r) < 0)
+            {
+                if (errors) errors->push_back(path + ":" + std::to_string(n) + ": more than " +
+                                              std::to_string(alarm_max_rules) + " rules, ignoring the rest");
+                break;
+            }
+            loaded++;
+        }
+        else if (!error.empty() && errors)
+            errors->push_back(path + ":" + std::to_string(n) + ": " + error);
+    }
+
+    return loaded;
+}
+//=============================================================================
+int AlarmEngine::addRule(const AlarmRule& rule)
+{
+    int id = (int)m_rules.size();
+    if (id >= alarm_max_rules) return -1;
+
+    m_rules.push_back({rule, false, 0, false, 0.0f, 0.0});
+    m_bySource[rule.source].push_back(id);
+    return id;
+}
+//=============================================================================
+void AlarmEngine::clear()
+{
+    m_rules.clear();
+    for (int s = 0; s < AS_Count; s++)
+    {
+        m_bySource[s].clear();
+        m_active[s] = 0;
+    }
+}
+//=============================================================================
+void AlarmEngine::feed(AlarmSource source, double t, float value)
+{
+    for (int id : m_bySource[source])
+    {
+        State& st          = m_rules[id];
+        const AlarmRule& r = st.rule;
+
+        float x = value;
+        if (r.kind == AK_Rate)
+        {
+            bool first = !st.hasLast || t <= st.lastT;
+            double dt  = t - st.lastT;
+            float last = st.last;
+
+            st.hasLast = true;
+            st.last    = value;
+            st.lastT   = t;
+            if (first) continue;
+
+            x = float(fabs(value - last) / dt);
+        }
+
+        bool violating, clear;
+        switch (r.kind)
+        {
+            case AK_Below:
+                violating = x < r.low;
+                clear     = x >= r.low + r.hysteresis;
+                break;
+            case AK_Outside:
+                violating = (x < r.low) | (x > r.high);
+                clear     = (x >= r.low + r.hysteresis) & (x <= r.high - r.hysteresis);
+                break;
+            default:  // AK_Above, AK_Rate
+                violating = x > r.high;
+                clear     = x <= r.high - r.hysteresis;
+                break;
+        }
+
+        if (!st.raised)
+        {
+            st.violations = violating ? (st.violations < UINT16_MAX ? st.violations + 1 : st.violations) : 0;
+            if (st.violations < r.count) continue;
+
+            st.raised = true;
+            m_active[source]++;
+            m_raisedTotal++;
+        }
+        else
+        {
+            if (!clear) continue;
+
+            st.raised     = false;
+            st.violations = 0;
+            m_active[source]--;
+        }
+
+        if (m_handler) m_handler({id, st.raised, x, t});
+    }
+}
+//=============================================================================
@@ -0,0 +1,112 @@
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define alarm_max_rules 256  // the trace tags an alarm with its rule index in one byte
+
+// Limit / alarm monitoring. Rules are evaluated incrementally on every value
+// of their source, each one keeps a few bytes of state, so feeding a value
+// costs O(1) per rule watching that source.
+//
+// Rule syntax, one per line (the GOKIT_ALARMS file, '#' starts a comment):
+//
+//   <source> above <high> [hyst <h>] [count <n>]
+//   <source> below <low> [hyst <h>] [count <n>]
+//   <source> outside <low> <high> [hyst <h>] [count <n>]
+//   <source> rate <limit per second> [hyst <h>] [count <n>]
+//
+// where <source> is mm, dso_mean or dso_rms. An alarm is raised after `n`
+// consecutive violations (default 1) and cleared once the value is back
+// within the limit by at least `h` (default 0). At most alarm_max_rules
+// rules are loaded.
+
+enum AlarmSource : uint8_t
+{
+    AS_MMValue = 0,  // every MMReading value
+    AS_DSOMean = 1,  // mean of every completed capture
+    AS_DSORms  = 2,  // RMS of every completed capture
+    AS_Count,
+};
+
+enum AlarmKind : uint8_t
+{
+    AK_Above   = 0,
+    AK_Below   = 1,
+    AK_Outside = 2,
+    AK_Rate    = 3,  // absolute rate of change, per second
+};
+
+struct AlarmRule
+{
+    AlarmSource source;
+    AlarmKind kind;
+    float low, high;  // AK_Rate: the limit is `high`
+    float hysteresis;
+    uint16_t count;  // consecutive violations to raise
+    std::string text;
+};
+
+struct AlarmEvent
+{
+    int rule;
+    bool raised;  // false: cleared
+    float value;
+    double t;  // seconds, as fed
+};
+
+const char* alarmSourceName(AlarmSource source);
+
+class AlarmEngine
+{
+   public:
+    typedef std::function<void(const AlarmEvent&)> Handler;
+
+    AlarmEngine();
+
+    // parses one rule line, empty lines and comments give false without error
+    static bool parseRule(const std::string& line, AlarmRule& out, std::string* error = nullptr);
+
+    // reads a rules file, returns the rules loaded, errors go to `errors`;
+    // the rules past alarm_max_rules are reported and ignored
+    int load(const std::string& path, std::vector<std::string>* errors = nullptr);
+
+    // rule index, -1 when alarm_max_rules are already in
+    int addRule(const AlarmRule& rule);
+    void clear();
+
+    const AlarmRule& rule(int id) const { return m_rules[id].rule; }
+    int ruleCount() const { return (int)m_rules.size(); }
+    bool empty() const { return m_rules.empty(); }
+
+    void setHandler(Handler handler) { m_handler = handler; }
+
+    // `t` in seconds, only used by AK_Rate rules
+    void feed(AlarmSource source, double t, float value);
+
+    // rules of `source` currently raised
+    uint32_t active(AlarmSource source) const { return m_active[source]; }
+    uint32_t raisedTotal() const { return m_raisedTotal; }
+
+   private:
+    struct State
+    {
+        AlarmRule rule;
+        bool raised;
+        uint16_t violations;
+        bool hasLast;
+        float last;
+        double lastT;
+    };
+
+    std::vector<State> m_rules;
+    std::vector<int> m_bySource[AS_Count];
+    uint32_t m_active[AS_Count];
+    uint32_t m_raisedTotal;
+    Handler m_handler;
+};
+
+#endif  // ALARMS_H
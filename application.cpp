@@ -0,0 +1,21 @@
+#include "application.h"
+
+#include <QEvent>
+
+static QElapsedTimer s_startClock;
+
+//=============================================================================
+Application::Application(int& argc, char** argv) : QApplication(argc, argv) { s_startClock.start(); }
+//=============================================================================
+qint64 Application::uptimeMs() { return s_startClock.isValid() ? s_startClock.elapsed() : -1; }
+//=============================================================================
+#if PERF_ENABLED == true
+bool Application::notify(QObject* receiver, QEvent* event)
+{
+    if (event->type() != QEvent::Paint) return QApplication::notify(receiver, event);
+
+    PERF_SCOPE(PS_Repaint);
+    return QApplication::notify(receiver, event);
+}
+#endif
+//=============================================================================
@@ -0,0 +1,23 @@
+#ifndef APPLICATION_H
+#define APPLICATION_H
+
+#include "perf.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+
+// QApplication that times every paint event into PS_Repaint when the perf
+// timers are compiled in, and is a plain QApplication otherwise.
+class Application : public QApplication
+{
+   public:
+    Application(int& argc, char** argv);
+
+    static qint64 uptimeMs();  // since the application was constructed
+
+#if PERF_ENABLED == true
+    virtual bool notify(QObject* receiver, QEvent* event) override;
+#endif
+};
+
+#endif  // APPLICATION_H
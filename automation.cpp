@@ -0,0 +1,77 @@
+#include "automation.h"
+
+//=============================================================================
+AutomationServer::AutomationServer(Sequencer* sequencer, QObject* parent)
+    : QObject(parent), m_sequencer(sequencer), m_nextId(1)
+{
+    m_sequencer->setReply([this](int id, const std::string& line) { _reply(id, line); });
+    connect(&m_server, SIGNAL(newConnection()), this, SLOT(_onNewConnection()));
+}
+//=============================================================================
+bool AutomationServer::listen(const QString& name)
+{
+    // a stale socket file of a crashed run would make listen() fail
+    QLocalServer::removeServer(name);
+    return m_server.listen(name);
+}
+//=============================================================================
+void AutomationServer::_onNewConnection()
+{
+    while (QLocalSocket* socket = m_server.nextPendingConnection())
+    {
+        int id            = m_nextId++;
+        m_clients[socket] = {id, 0};
+        m_sockets[id]     = socket;
+
+        connect(socket, SIGNAL(readyRead()), this, SLOT(_onReadyRead()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(_onDisconnected()));
+    }
+}
+//=============================================================================
+void AutomationServer::_onReadyRead()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket || !m_clients.contains(socket)) return;
+
+    Client& c = m_clients[socket];
+
+    while (socket->canReadLine())
+    {
+        QByteArray line = socket->readLine().trimmed();
+        c.line++;
+
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        if (line == "abort")
+        {
+            m_sequencer->abort(c.id);
+            _reply(c.id, "ok");
+        }
+        else if (line == "status")
+            _reply(c.id, "status " + std::to_string(m_sequencer->pending()));
+        else
+            m_sequencer->queue(c.id, c.line, line.toStdString());
+    }
+}
+//=============================================================================
+void AutomationServer::_onDisconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket || !m_clients.contains(socket)) return;
+
+    int id = m_clients.take(socket).id;
+    m_sockets.remove(id);
+    m_sequencer->abort(id);
+
+    socket->deleteLater();
+}
+//=============================================================================
+void AutomationServer::_reply(int id, const std::string& line)
+{
+    QLocalSocket* socket = m_sockets.value(id);
+    if (!socket) return;
+
+    socket->write(line.data(), (qint64)line.size());
+    socket->write("\n", 1);
+}
+//=============================================================================
@@ -0,0 +1,52 @@
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+
+#include "sequencer.h"
+
+// Local socket command API (GOKIT_API=<name>). Clients send measurement
+// plan lines (see sequencer.h), one per line, and get the sequencer replies
+// back on the same socket. Besides the plan steps:
+//
+//   abort     drops the steps queued by this client, and clears an error
+//   status    replies "status <steps queued by every client>"
+//
+// A client disconnecting aborts its plan.
+class AutomationServer : public QObject
+{
+    Q_OBJECT
+
+   public:
+    AutomationServer(Sequencer* sequencer, QObject* parent = nullptr);
+
+    bool listen(const QString& name);
+    bool isListening() const { return m_server.isListening(); }
+
+    uint32_t clients() const { return (uint32_t)m_clients.size(); }
+
+   private:
+    struct Client
+    {
+        int id;         // for the sequencer
+        uint32_t line;  // last line received
+    };
+
+    Sequencer* m_sequencer;
+    QLocalServer m_server;
+    QHash<QLocalSocket*, Client> m_clients;
+    QHash<int, QLocalSocket*> m_sockets;
+    int m_nextId;
+
+    void _reply(int id, const std::string& line);
+
+   private slots:
+    void _onNewConnection();
+    void _onReadyRead();
+    void _onDisconnected();
+};
+
+#endif  // AUTOMATION_H
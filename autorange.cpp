@@ -0,0 +1,114 @@
+#include "autorange.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define autorange_up 0.9f       // of the full scale, switch up above it
+#define autorange_target 0.6f   // of the full scale, where a new range puts the value
+#define autorange_down_count 2  // consecutive readings fitting a lower range to switch down
+
+#define settle_high 0.95f  // of the full scale, saturated above it
+#define settle_low 0.5f    // of the lower range full scale, wasted resolution below it
+
+//=============================================================================
+AutoRange::AutoRange()
+    : m_desc(nullptr), m_range(0), m_pending(false), m_hasLast(false), m_last(0.0f), m_below(0), m_switches(0)
+{
+}
+//=============================================================================
+void AutoRange::setMode(MultimeterMode mode)
+{
+    m_desc    = &mmMode(mode);
+    m_range   = m_desc->rangeCount ? m_desc->rangeCount - 1 : 0;
+    m_pending = true;
+    m_hasLast = false;
+    m_below   = 0;
+}
+//=============================================================================
+uint8_t AutoRange::_fit(float x) const
+{
+    for (uint8_t r = 0; r < m_desc->rangeCount; r++)
+        if (x <= autorange_target * m_desc->ranges[r].fullScale) return r;
+    return m_desc->rangeCount - 1;
+}
+//=============================================================================
+bool AutoRange::update(const MMReading& reading)
+{
+    if (!m_desc || !m_desc->rangeCount) return false;
+
+    // readings still taken in the previous range say nothing about this one
+    if (m_pending)
+    {
+        if (reading.range != m_range) return false;
+        m_pending = false;
+        m_hasLast = false;
+    }
+
+    // one reading ahead, linear
+    float pred = m_hasLast ? 2.0f * reading.value - m_last : reading.value;
+    float x    = std::max(fabsf(reading.value), fabsf(pred));
+
+    m_last    = reading.value;
+    m_hasLast = true;
+
+    uint8_t top    = m_desc->rangeCount - 1;
+    uint8_t target = m_range;
+
+    if (reading.status == 255)
+        target = top;  // overload, the value is meaningless
+    else if (x > autorange_up * rangeFullScale(*m_desc, m_range))
+    {
+        // straight to the range that fits, not one step at a time
+        target = _fit(x);
+        if (target <= m_range) target = m_range < top ? m_range + 1 : top;
+    }
+    else
+    {
+        uint8_t fit = _fit(x);
+        m_below     = fit < m_range ? m_below + 1 : 0;
+        if (m_below >= autorange_down_count) target = fit;
+    }
+
+    if (target == m_range) return false;
+
+    m_range   = target;
+    m_pending = true;
+    m_below   = 0;
+    m_switches++;
+    return true;
+}
+//=============================================================================
+RangeSettleMeter::RangeSettleMeter() { reset(); }
+//=============================================================================
+void RangeSettleMeter::reset()
+{
+    m_settling = false;
+    m_start    = 0.0;
+    m_count    = 0;
+    m_lastMs   = 0.0;
+    m_totalMs  = 0.0;
+}
+//=============================================================================
+void RangeSettleMeter::update(const MMReading& reading, double t)
+{
+    const ModeDesc& desc = mmMode(reading.mode);
+    if (reading.range >= desc.rangeCount) return;
+
+    float v     = fabsf(reading.value);
+    bool usable = reading.status != 255 && v <= settle_high * desc.ranges[reading.range].fullScale;
+    if (reading.range > 0) usable &= v >= settle_low * desc.ranges[reading.range - 1].fullScale;
+
+    if (!usable && !m_settling)
+    {
+        m_settling = true;
+        m_start    = t;
+    }
+    else if (usable && m_settling)
+    {
+        m_settling = false;
+        m_lastMs   = (t - m_start) * 1000.0;
+        m_totalMs += m_lastMs;
+        m_count++;
+    }
+}
+//=============================================================================
@@ -0,0 +1,69 @@
+#ifndef AUTORANGE_H
+#define AUTORANGE_H
+
+#include "protocol.h"
+#include "ranges.h"
+
+#include <cstdint>
+
+// Range selector id of the host side autorange, next to range_auto (the
+// device one). The settings written to the device always carry a fixed range.
+#define range_predictive 254
+
+// Host side predictive autorange. Every reading is compared with the full
+// scale of the range it was taken in, the next value is extrapolated from
+// the last two and the best fixed range is requested before the meter
+// saturates or loses resolution, jumping straight to it instead of
+// stepping through the ranges like the device does.
+class AutoRange
+{
+   public:
+    AutoRange();
+
+    // new mode, restarts from the highest (safest) range
+    void setMode(MultimeterMode mode);
+    uint8_t range() const { return m_range; }
+
+    // true when `range()` changed and must be written to the device
+    bool update(const MMReading& reading);
+
+    uint32_t switches() const { return m_switches; }
+
+   private:
+    const ModeDesc* m_desc;
+    uint8_t m_range;
+    bool m_pending;  // waiting for a reading taken in m_range
+    bool m_hasLast;
+    float m_last;
+    uint8_t m_below;  // consecutive readings fitting a lower range
+    uint32_t m_switches;
+
+    uint8_t _fit(float x) const;
+};
+
+// Range settle latency: from the first reading out of the usable window of
+// its range (saturated, or so small that a lower range exists) to the first
+// reading back inside it. One per ranging mode, device AUTO and host PRED,
+// fed with the readings while that mode is selected, so the two can be
+// compared.
+class RangeSettleMeter
+{
+   public:
+    RangeSettleMeter();
+
+    void update(const MMReading& reading, double t);
+    void reset();
+    void interrupt() { m_settling = false; }  // drops the settle in progress, if any
+
+    uint32_t count() const { return m_count; }
+    double lastMs() const { return m_lastMs; }
+    double meanMs() const { return m_count ? m_totalMs / m_count : 0.0; }
+
+   private:
+    bool m_settling;
+    double m_start;
+    uint32_t m_count;
+    double m_lastMs, m_totalMs;
+};
+
+#endif  // AUTORANGE_H
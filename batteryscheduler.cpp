@@ -0,0 +1,98 @@
+#include "batteryscheduler.h"
+
+#define battery_sample_period 15.0  // s, decimation of the status notifications
+#define battery_min_span 120.0      // s of history needed before trusting the slope
+#define slowdown_max 20.0f
+#define slowdown_step 0.2f  // relative change needed before the factor moves
+
+//=============================================================================
+BatteryScheduler::BatteryScheduler() : m_cutoff(battery_cutoff_volt) { reset(); }
+//=============================================================================
+void BatteryScheduler::reset()
+{
+    m_count        = 0;
+    m_first        = 0;
+    m_targetStart  = 0.0;
+    m_targetLength = 0.0;
+    m_runtime      = -1.0;
+    m_factor       = 1.0f;
+}
+//=============================================================================
+void BatteryScheduler::addSample(double t, float volt)
+{
+    if (m_count)
+    {
+        int last = (m_first + m_count - 1) % battery_max_points;
+        if (t - m_t[last] < battery_sample_period) return;
+    }
+
+    int slot  = (m_first + m_count) % battery_max_points;
+    m_t[slot] = t;
+    m_v[slot] = volt;
+
+    if (m_count < battery_max_points)
+        m_count++;
+    else
+        m_first = (m_first + 1) % battery_max_points;
+
+    _update(t);
+}
+//=============================================================================
+void BatteryScheduler::setTarget(double t, double seconds)
+{
+    m_targetStart  = t;
+    m_targetLength = seconds;
+    if (seconds <= 0.0) m_factor = 1.0f;
+}
+//=============================================================================
+void BatteryScheduler::_update(double now)
+{
+    m_runtime = -1.0;
+    if (m_count < 3) return;
+
+    // least squares fit v = a + b * t, centered on the mean time for precision
+    double mt = 0.0, mv = 0.0;
+    for (int i = 0; i < m_count; i++)
+    {
+        int k = (m_first + i) % battery_max_points;
+        mt += m_t[k];
+        mv += m_v[k];
+    }
+    mt /= m_count;
+    mv /= m_count;
+
+    double sxy = 0.0, sxx = 0.0;
+    for (int i = 0; i < m_count; i++)
+    {
+        int k     = (m_first + i) % battery_max_points;
+        double dt = m_t[k] - mt;
+        sxy += dt * (m_v[k] - mv);
+        sxx += dt * dt;
+    }
+
+    double span = m_t[(m_first + m_count - 1) % battery_max_points] - m_t[m_first];
+    if (span < battery_min_span || sxx <= 0.0) return;
+
+    double slope = sxy / sxx;  // V/s
+    if (slope >= 0.0) return;  // charging or flat: nothing to project
+
+    double vnow = mv + slope * (now - mt);
+    m_runtime   = vnow > m_cutoff ? (vnow - m_cutoff) / -slope : 0.0;
+
+    if (m_targetLength <= 0.0) return;
+
+    double needed = m_targetLength - (now - m_targetStart);
+    if (needed <= 0.0)
+    {
+        m_factor = 1.0f;
+        return;
+    }
+
+    float f = m_runtime > 0.0 ? float(m_factor * needed / m_runtime) : slowdown_max;
+    if (f < 1.0f) f = 1.0f;
+    if (f > slowdown_max) f = slowdown_max;
+
+    // avoid rewriting the settings for every small wobble of the estimate
+    if (f > m_factor * (1.0f + slowdown_step) || f < m_factor * (1.0f - slowdown_step)) m_factor = f;
+}
+//=============================================================================
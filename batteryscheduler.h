@@ -0,0 +1,55 @@
+#ifndef BATTERYSCHEDULER_H
+#define BATTERYSCHEDULER_H
+
+#include <cstdint>
+
+#define battery_max_points 64
+#define battery_cutoff_volt 3.3f  // default, Li-ion cell (4.2V charged)
+
+// Estimates the remaining runtime from the battery voltage trend (linear
+// fit over a sliding window of decimated DeviceStatus samples) and, given a
+// target session length, computes how much the acquisition must be slowed
+// down to reach it. The slowdown is a multiplicative controller: the trend
+// is measured at the current pace, so the factor is corrected by the ratio
+// between the time still required and the projected runtime.
+class BatteryScheduler
+{
+   public:
+    BatteryScheduler();
+
+    void reset();
+
+    // `t` in seconds on a monotonic clock
+    void addSample(double t, float volt);
+
+    // voltage at which the device is considered flat, depends on the cell
+    void setCutoff(float volt) { m_cutoff = volt; }
+
+    // 0 disables the scheduling (factor stays 1)
+    void setTarget(double t, double seconds);
+
+    // seconds left before the cutoff voltage, < 0 while unknown
+    double projectedRuntime() const { return m_runtime; }
+
+    // >= 1, how much longer than nominal the acquisition intervals should be
+    float slowdown() const { return m_factor; }
+
+    uint32_t mmInterval(uint32_t nominalMs) const { return uint32_t(nominalMs * m_factor); }
+
+    // pause to insert after a DSO capture lasting `captureMs`
+    uint32_t dsoHoldoff(uint32_t captureMs) const { return uint32_t(captureMs * (m_factor - 1.0f)); }
+
+   private:
+    double m_t[battery_max_points];
+    float m_v[battery_max_points];
+    int m_count, m_first;
+
+    double m_targetStart, m_targetLength;
+    double m_runtime;
+    float m_factor;
+    float m_cutoff;
+
+    void _update(double now);
+};
+
+#endif  // BATTERYSCHEDULER_H
@@ -0,0 +1,108 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+//=============================================================================
+CaptureBuffer::CaptureBuffer() : m_start(0.0), m_period(0.0) { memset(&m_metadata, 0, sizeof(m_metadata)); }
+//=============================================================================
+void CaptureBuffer::reset(const DSOMetadata& metadata)
+{
+    m_metadata = metadata;
+    m_start    = 0.0;
+    m_period   = 0.0;
+
+    m_samples.clear();
+    m_samples.reserve(metadata.samples);
+
+    m_sum.assign(1, 0.0);
+    m_sumSq.assign(1, 0.0);
+    m_sum.reserve(metadata.samples + 1);
+    m_sumSq.reserve(metadata.samples + 1);
+}
+//=============================================================================
+float* CaptureBuffer::append(const int16_t* raw, uint32_t n)
+{
+    // blocks past the announced length still go in, the device is the
+    // authority on the sample count and reserve() only sizes the fast path
+    size_t at = m_samples.size();
+    m_samples.resize(at + n);
+
+    float* out  = m_samples.data() + at;
+    float scale = m_metadata.scale;
+    for (uint32_t i = 0; i < n; i++) out[i] = raw[i] * scale;
+
+    double sum   = m_sum.back();
+    double sumSq = m_sumSq.back();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sum += out[i];
+        sumSq += (double)out[i] * out[i];
+        m_sum.push_back(sum);
+        m_sumSq.push_back(sumSq);
+    }
+
+    return out;
+}
+//=============================================================================
+double CaptureBuffer::samplePeriod() const
+{
+    if (!m_metadata.samples) return 0.0;
+    return m_metadata.window * 1e-6 / m_metadata.samples;
+}
+//=============================================================================
+uint32_t CaptureBuffer::sampleAt(double seconds) const
+{
+    double dt = samplePeriod();
+    if (dt <= 0.0 || seconds <= 0.0) return 0;
+
+    double i = seconds / dt + 0.5;
+    return i >= size() ? size() : (uint32_t)i;
+}
+//=============================================================================
+WindowStats CaptureBuffer::window(uint32_t from, uint32_t to) const
+{
+    WindowStats st = {};
+
+    if (from > to) std::swap(from, to);
+    if (to > size()) to = size();
+    if (from >= to) return st;
+
+    double dt    = samplePeriod();
+    double sum   = m_sum[to] - m_sum[from];
+    double sumSq = m_sumSq[to] - m_sumSq[from];
+
+    st.count    = to - from;
+    st.seconds  = st.count * dt;
+    st.mean     = sum / st.count;
+    st.rms      = sqrt(sumSq / st.count);
+    st.integral = sum * dt;
+    st.energy   = sumSq * dt;
+
+    return st;
+}
+//=============================================================================
+bool CaptureBuffer::save(const std::string& path, const float* x, uint32_t n) const
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    if (!x)
+    {
+        x = m_samples.data();
+        n = size();
+    }
+
+    fprintf(f, "# mode %u range %u window_us %u samples %u rate %u scale %g start_s %.6f\n", m_metadata.mode,
+            m_metadata.range, m_metadata.window, n, m_metadata.samplingRate, m_metadata.scale, m_start);
+    fprintf(f, "t_ms,value\n");
+
+    // the corrected period when known, the device one is off by its clock drift
+    double dt = (m_period > 0.0 ? m_period : samplePeriod()) * 1000.0;
+    for (uint32_t i = 0; i < n; i++) fprintf(f, "%.6f,%g\n", i * dt, x[i]);
+
+    return fclose(f) == 0;
+}
+//=============================================================================
@@ -0,0 +1,76 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "protocol.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Statistics of a window of samples, in the capture unit
+struct WindowStats
+{
+    uint32_t count;
+    double seconds;
+    double mean;
+    double rms;
+    double integral;  // of x over time, e.g. the charge of a current capture
+    double energy;    // of x² over time
+};
+
+// Decoded samples of the DSO acquisition in progress, filled block by block
+// as the DSOReading notifications arrive. The storage is reserved once per
+// capture from the metadata, appending a block never allocates.
+//
+// Prefix sums of x and x² are extended with every block, so the statistics
+// of any window (e.g. between two cursors) cost two lookups per sum instead
+// of a pass over the samples.
+class CaptureBuffer
+{
+   public:
+    CaptureBuffer();
+
+    // starts a new capture described by `metadata`
+    void reset(const DSOMetadata& metadata);
+
+    // decodes `n` raw samples with the capture scale, returns the new block
+    // (valid until the next append)
+    float* append(const int16_t* raw, uint32_t n);
+
+    const DSOMetadata& metadata() const { return m_metadata; }
+    const float* data() const { return m_samples.data(); }
+    uint32_t size() const { return (uint32_t)m_samples.size(); }
+    uint32_t expected() const { return m_metadata.samples; }
+    bool complete() const { return size() >= expected(); }
+
+    // seconds between two samples
+    double samplePeriod() const;
+
+    // corrected time of the first sample and sample period, host monotonic
+    // seconds (see sampleclock.h), zero until set for the capture
+    void setTiming(double start, double period)
+    {
+        m_start  = start;
+        m_period = period;
+    }
+    double start() const { return m_start; }
+
+    // index of the sample at `seconds` from the start of the capture
+    uint32_t sampleAt(double seconds) const;
+
+    // samples [from, to), clamped to what was received so far, O(1)
+    WindowStats window(uint32_t from, uint32_t to) const;
+
+    // CSV dump (time in ms, value), the metadata and the corrected start time
+    // go in a comment line. The `n` samples of `x` are written instead of the
+    // capture ones when given (e.g. the averaged trace)
+    bool save(const std::string& path, const float* x = nullptr, uint32_t n = 0) const;
+
+   private:
+    DSOMetadata m_metadata;
+    std::vector<float> m_samples;
+    std::vector<double> m_sum, m_sumSq;  // m_sum[i] = x[0] + ... + x[i - 1]
+    double m_start, m_period;
+};
+
+#endif  // CAPTURE_H
@@ -0,0 +1,103 @@
+#include "devicecache.h"
+
+#include <QByteArray>
+#include <QSettings>
+
+#include <cstring>
+
+#define cache_version 1
+
+//=============================================================================
+template <typename T>
+static QByteArray _toBytes(const T& x)
+{
+    return QByteArray((const char*)&x, sizeof(x));
+}
+//=============================================================================
+template <typename T>
+static bool _fromBytes(const QByteArray& b, T& x)
+{
+    if (b.size() != (int)sizeof(x)) return false;
+    memcpy(&x, b.constData(), sizeof(x));
+    return true;
+}
+//=============================================================================
+DeviceCache::DeviceCache() {}
+//=============================================================================
+DeviceProfile DeviceCache::emptyProfile()
+{
+    DeviceProfile p;
+    p.hasData    = false;
+    p.hasMM      = false;
+    p.mmSelected = 0;
+    p.hasDSO     = false;
+    memset(&p.data, 0, sizeof(p.data));
+    memset(p.layout, 0, sizeof(p.layout));
+    memset(&p.mm, 0, sizeof(p.mm));
+    memset(&p.dso, 0, sizeof(p.dso));
+    return p;
+}
+//=============================================================================
+bool DeviceCache::find(const QString& peripheralUuid, DeviceProfile& out) const
+{
+    QSettings s("gokit", "gokit");
+
+    QString mac = s.value("peripherals/" + peripheralUuid).toString();
+    if (mac.isEmpty()) return false;
+
+    s.beginGroup("devices/" + mac);
+    if (s.value("version").toInt() != cache_version) return false;
+
+    DeviceProfile p = emptyProfile();
+    p.mac           = mac;
+    p.name          = s.value("name").toString();
+    p.hasData       = _fromBytes(s.value("data").toByteArray(), p.data);
+    p.hasMM         = _fromBytes(s.value("mm").toByteArray(), p.mm);
+    p.hasDSO        = _fromBytes(s.value("dso").toByteArray(), p.dso);
+    p.mmSelected    = (uint8_t)s.value("mm_selected", p.mm.range).toUInt();
+
+    for (int i = 0; i < PSRV_Count; i++) p.layout[i] = s.value(QString("layout/%1").arg(i)).toUInt();
+
+    out = p;
+    return true;
+}
+//=============================================================================
+bool DeviceCache::isKnown(const QString& peripheralUuid) const
+{
+    QSettings s("gokit", "gokit");
+    return s.contains("peripherals/" + peripheralUuid);
+}
+//=============================================================================
+QSet<QString> DeviceCache::knownPeripherals() const
+{
+    QSettings s("gokit", "gokit");
+    s.beginGroup("peripherals");
+
+    QSet<QString> known;
+    for (const QString& k : s.childKeys()) known.insert(k);
+    return known;
+}
+//=============================================================================
+void DeviceCache::store(const QString& peripheralUuid, const DeviceProfile& profile)
+{
+    if (profile.mac.isEmpty() || peripheralUuid.isEmpty()) return;
+
+    QSettings s("gokit", "gokit");
+    s.setValue("peripherals/" + peripheralUuid, profile.mac);
+
+    s.beginGroup("devices/" + profile.mac);
+    s.setValue("version", cache_version);
+    s.setValue("name", profile.name);
+    if (profile.hasData) s.setValue("data", _toBytes(profile.data));
+    if (profile.hasMM) s.setValue("mm", _toBytes(profile.mm));
+    if (profile.hasMM) s.setValue("mm_selected", profile.mmSelected);
+    if (profile.hasDSO) s.setValue("dso", _toBytes(profile.dso));
+
+    for (int i = 0; i < PSRV_Count; i++) s.setValue(QString("layout/%1").arg(i), profile.layout[i]);
+}
+//=============================================================================
+QString DeviceCache::macToStr(const uint8_t* mac)
+{
+    return QString::asprintf("%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+//=============================================================================
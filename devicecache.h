@@ -0,0 +1,48 @@
+#ifndef DEVICECACHE_H
+#define DEVICECACHE_H
+
+#include "protocol.h"
+
+#include <QSet>
+#include <QString>
+
+// Everything gokit remembers about a meter between connections
+struct DeviceProfile
+{
+    QString mac;  // empty until the device characteristic has been read once
+    QString name;
+
+    bool hasData;
+    DeviceData data;
+
+    uint32_t layout[PSRV_Count];  // per service, bit n set when PokitChar n was discovered
+
+    bool hasMM;
+    MMSettings mm;       // last settings written
+    uint8_t mmSelected;  // range selector choice then: mm.range, range_auto or the host autorange
+
+    bool hasDSO;
+    DSOSettings dso;  // last settings written
+};
+
+// Persistent device profiles (QSettings), keyed by the MAC address read from
+// DeviceData. The platform peripheral identifier is indexed too, since it
+// is all we know about a device until its device characteristic is read.
+class DeviceCache
+{
+   public:
+    DeviceCache();
+
+    static DeviceProfile emptyProfile();
+
+    bool find(const QString& peripheralUuid, DeviceProfile& out) const;
+    bool isKnown(const QString& peripheralUuid) const;
+    QSet<QString> knownPeripherals() const;
+
+    // no-op as long as the profile has no MAC address or there is no peripheral (replay)
+    void store(const QString& peripheralUuid, const DeviceProfile& profile);
+
+    static QString macToStr(const uint8_t* mac);
+};
+
+#endif  // DEVICECACHE_H
@@ -0,0 +1,66 @@
+#ifndef LABELCACHE_H
+#define LABELCACHE_H
+
+#include <QLabel>
+#include <QString>
+
+#include <cstdint>
+
+// Counters shared by every CachedLabel (GUI thread only)
+struct LabelCacheStats
+{
+    uint64_t sets;           // setText calls actually performed
+    uint64_t skipped;        // updates dropped because the raw value did not change
+    uint64_t allocsAvoided;  // QString allocations the skipped formatting would have made
+};
+
+inline LabelCacheStats labelCacheStats = {};
+
+// QLabel front-end keyed on the raw value shown by the label: the text is
+// formatted and set only when the value differs from the last one, so high
+// rate notifications carrying the same data cost a single comparison.
+template <typename T>
+class CachedLabel
+{
+   public:
+    typedef QString (*Formatter)(const T&);
+
+    // `allocs` is the number of QString allocations one call to `format` makes
+    CachedLabel(Formatter format, uint8_t allocs = 1)
+        : m_label(nullptr), m_format(format), m_allocs(allocs), m_valid(false), m_last()
+    {
+    }
+
+    void attach(QLabel* label)
+    {
+        m_label = label;
+        m_valid = false;
+    }
+
+    void set(const T& value)
+    {
+        if (m_valid && value == m_last)
+        {
+            labelCacheStats.skipped++;
+            labelCacheStats.allocsAvoided += m_allocs;
+            return;
+        }
+
+        m_last  = value;
+        m_valid = true;
+        labelCacheStats.sets++;
+        if (m_label) m_label->setText(m_format(value));
+    }
+
+    // forces the next set() to refresh the label
+    void invalidate() { m_valid = false; }
+
+   private:
+    QLabel* m_label;
+    Formatter m_format;
+    uint8_t m_allocs;
+    bool m_valid;
+    T m_last;
+};
+
+#endif  // LABELCACHE_H
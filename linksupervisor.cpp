@@ -0,0 +1,81 @@
+#include "linksupervisor.h"
+
+#define backoff_min_ms 250
+#define backoff_max_ms 30000
+
+//=============================================================================
+LinkSupervisor::LinkSupervisor(TimerWheel* wheel, QObject* parent)
+    : QObject(parent),
+      m_state(LS_Idle),
+      m_wheel(wheel),
+      m_backoffTimer(wheel->add([this]() { _onBackoffTimeout(); })),
+      m_backoffMs(backoff_min_ms),
+      m_lastOutageMs(0),
+      m_maxOutageMs(0),
+      m_outages(0)
+{
+}
+//=============================================================================
+void LinkSupervisor::connectRequested(const QString& peripheralUuid)
+{
+    m_peripheral = peripheralUuid;
+    m_state      = LS_Connecting;
+    m_wheel->stop(m_backoffTimer);
+}
+//=============================================================================
+void LinkSupervisor::disconnectRequested()
+{
+    m_state = LS_Idle;
+    m_wheel->stop(m_backoffTimer);
+}
+//=============================================================================
+void LinkSupervisor::connected()
+{
+    bool restored = m_state == LS_Lost;
+
+    m_state     = LS_Connected;
+    m_backoffMs = backoff_min_ms;
+    m_wheel->stop(m_backoffTimer);
+
+    if (!restored) return;
+
+    m_lastOutageMs = m_outage.elapsed();
+    if (m_lastOutageMs > m_maxOutageMs) m_maxOutageMs = m_lastOutageMs;
+    m_outages++;
+
+    emit linkRestored(m_lastOutageMs);
+}
+//=============================================================================
+void LinkSupervisor::disconnected()
+{
+    switch (m_state)
+    {
+        case LS_Connected:
+            m_state = LS_Lost;
+            m_outage.start();
+            emit linkLost();
+            break;
+
+        case LS_Lost:
+            break;  // a reconnect attempt failed, keep backing off
+
+        default:
+            m_state = LS_Idle;
+            return;
+    }
+
+    m_wheel->start(m_backoffTimer, m_backoffMs);
+}
+//=============================================================================
+void LinkSupervisor::_onBackoffTimeout()
+{
+    if (m_state != LS_Lost) return;
+
+    // the platform keeps a connect request pending until the device shows
+    // up again, re-issuing it with a growing period covers failed attempts
+    m_backoffMs = qMin(m_backoffMs * 2, backoff_max_ms);
+    m_wheel->start(m_backoffTimer, m_backoffMs);
+
+    emit reconnectAttempt(m_peripheral);
+}
+//=============================================================================
@@ -0,0 +1,59 @@
+#ifndef LINKSUPERVISOR_H
+#define LINKSUPERVISOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+
+#include "timerwheel.h"
+
+enum LinkState : uint8_t
+{
+    LS_Idle       = 0,  // not connected, nothing to do
+    LS_Connecting = 1,  // connect requested by the user
+    LS_Connected  = 2,
+    LS_Lost       = 3,  // link dropped, reconnect attempt pending or in progress
+};
+
+// Connection state machine. A link that drops without the user asking for
+// it is reconnected with an exponential backoff (reconnectAttempt) until
+// it comes back or the user gives up; every outage is timed.
+class LinkSupervisor : public QObject
+{
+    Q_OBJECT
+
+   public:
+    LinkSupervisor(TimerWheel* wheel, QObject* parent = nullptr);
+
+    LinkState state() const { return m_state; }
+    const QString& peripheral() const { return m_peripheral; }
+
+    void connectRequested(const QString& peripheralUuid);
+    void disconnectRequested();  // by the user, no reconnection
+    void connected();
+    void disconnected();
+
+    qint64 lastOutageMs() const { return m_lastOutageMs; }
+    qint64 maxOutageMs() const { return m_maxOutageMs; }
+    uint32_t outages() const { return m_outages; }
+
+   signals:
+    void reconnectAttempt(const QString& peripheralUuid);
+    void linkLost();
+    void linkRestored(qint64 outageMs);
+
+   private:
+    LinkState m_state;
+    QString m_peripheral;
+    TimerWheel* m_wheel;
+    int m_backoffTimer;
+    QElapsedTimer m_outage;
+    int m_backoffMs;
+
+    qint64 m_lastOutageMs, m_maxOutageMs;
+    uint32_t m_outages;
+
+    void _onBackoffTimeout();
+};
+
+#endif  // LINKSUPERVISOR_H
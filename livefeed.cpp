@@ -0,0 +1,219 @@
+#include "livefeed.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define feed_size (sizeof(FeedHeader) + size_t(feed_slot_size) * feed_slot_count)
+
+//=============================================================================
+static inline uint64_t _monoNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+//=============================================================================
+static inline FeedSlot* _slot(const FeedHeader* h, uint64_t n)
+{
+    uint8_t* base = (uint8_t*)h + h->headerSize;
+    return (FeedSlot*)(base + (n % h->slotCount) * h->slotSize);
+}
+//=============================================================================
+LiveFeed::LiveFeed() : m_header(nullptr), m_size(0), m_next(0), m_start(0) {}
+//=============================================================================
+LiveFeed::~LiveFeed() { close(); }
+//=============================================================================
+bool LiveFeed::open(const std::string& name)
+{
+    close();
+
+    // a stale object of a previous run may have a different size
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return false;
+
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, feed_size) == 0) p = mmap(nullptr, feed_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name   = name;
+    m_header = (FeedHeader*)p;
+    m_size   = feed_size;
+    m_next   = 0;
+    m_start  = _monoNs();
+
+    m_header->version      = feed_version;
+    m_header->headerSize   = sizeof(FeedHeader);
+    m_header->slotSize     = feed_slot_size;
+    m_header->slotCount    = feed_slot_count;
+    m_header->startEpochNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+    m_header->head.store(0, std::memory_order_relaxed);
+
+    // the magic goes last: a reader seeing it sees a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(m_header->magic, feed_magic, sizeof(m_header->magic));
+
+    return true;
+}
+//=============================================================================
+void LiveFeed::close()
+{
+    if (!m_header) return;
+
+    munmap(m_header, m_size);
+    shm_unlink(m_name.c_str());
+    m_header = nullptr;
+}
+//=============================================================================
+void LiveFeed::publish(FeedRecordType type, const void* data, uint32_t size, double t)
+{
+    if (!m_header) return;
+    if (size > feed_payload_max) size = feed_payload_max;
+
+    uint64_t n  = m_next++;
+    FeedSlot* s = _slot(m_header, n);
+
+    // seqlock: odd while the slot is being rewritten
+    s->seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t ns = t > 0.0 ? (uint64_t)(t * 1e9) : _monoNs();
+    s->ns       = ns > m_start ? ns - m_start : 0;
+    s->type = type;
+    s->size = (uint16_t)size;
+    memcpy((uint8_t*)(s + 1), data, size);
+
+    s->seq.store(2 * n + 2, std::memory_order_release);
+    m_header->head.store(m_next, std::memory_order_release);
+}
+//=============================================================================
+void LiveFeed::block(uint32_t offset, const float* x, uint32_t n, double t, double period)
+{
+    if (!m_header) return;
+
+    const uint32_t perRecord = (feed_payload_max - sizeof(FeedBlock)) / sizeof(float);
+    uint8_t buf[feed_payload_max];
+
+    for (uint32_t i = 0; i < n; i += perRecord)
+    {
+        FeedBlock b;
+        b.offset = offset + i;
+        b.count  = n - i < perRecord ? n - i : perRecord;
+
+        memcpy(buf, &b, sizeof(b));
+        memcpy(buf + sizeof(b), x + i, b.count * sizeof(float));
+        publish(FR_DSOBlock, buf, uint32_t(sizeof(b) + b.count * sizeof(float)), t > 0.0 ? t + i * period : 0.0);
+    }
+}
+//=============================================================================
+LiveFeedReader::LiveFeedReader() : m_header(nullptr), m_size(0), m_next(0), m_lost(0) {}
+//=============================================================================
+LiveFeedReader::~LiveFeedReader() { close(); }
+//=============================================================================
+bool LiveFeedReader::open(const std::string& name, std::string* error)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        if (error) *error = name + ": no such feed";
+        return false;
+    }
+
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(FeedHeader))
+        p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+    {
+        if (error) *error = name + ": can't map the feed";
+        return false;
+    }
+
+    const FeedHeader* h = (const FeedHeader*)p;
+    bool ok = memcmp(h->magic, feed_magic, sizeof(h->magic)) == 0 && h->version == feed_version;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    ok = ok && h->slotSize > sizeof(FeedSlot) && h->slotCount &&
+         h->headerSize + size_t(h->slotSize) * h->slotCount <= (size_t)st.st_size;
+
+    if (!ok)
+    {
+        munmap(p, st.st_size);
+        if (error) *error = name + ": not a gokit v" + std::to_string(feed_version) + " feed";
+        return false;
+    }
+
+    m_header = h;
+    m_size   = st.st_size;
+    m_next   = h->head.load(std::memory_order_acquire);
+    m_lost   = 0;
+    return true;
+}
+//=============================================================================
+void LiveFeedReader::close()
+{
+    if (!m_header) return;
+
+    munmap((void*)m_header, m_size);
+    m_header = nullptr;
+}
+//=============================================================================
+bool LiveFeedReader::next(FeedSlot& slot, std::vector<uint8_t>& payload)
+{
+    if (!m_header) return false;
+
+    for (;;)
+    {
+        uint64_t head = m_header->head.load(std::memory_order_acquire);
+        if (m_next >= head) return false;
+
+        // lapped: skip to the oldest record still in the ring
+        if (head - m_next > m_header->slotCount)
+        {
+            m_lost += head - m_header->slotCount - m_next;
+            m_next = head - m_header->slotCount;
+        }
+
+        const FeedSlot* s = _slot(m_header, m_next);
+        uint64_t want     = 2 * m_next + 2;
+
+        uint64_t seq = s->seq.load(std::memory_order_acquire);
+        if (seq < want) return false;  // not complete yet
+
+        if (seq == want)
+        {
+            slot.ns   = s->ns;
+            slot.type = s->type;
+            slot.size = s->size <= m_header->slotSize - sizeof(FeedSlot) ? s->size : 0;
+            payload.assign((const uint8_t*)(s + 1), (const uint8_t*)(s + 1) + slot.size);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->seq.load(std::memory_order_relaxed) == want)
+            {
+                slot.seq.store(want, std::memory_order_relaxed);
+                m_next++;
+                return true;
+            }
+        }
+
+        // overwritten before or while being copied
+        m_lost++;
+        m_next++;
+    }
+}
+//=============================================================================
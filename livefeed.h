@@ -0,0 +1,146 @@
+#ifndef LIVEFEED_H
+#define LIVEFEED_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shared memory layout of the live data feed (POSIX shm object, native
+// little endian), for local analysis tools:
+//
+//   FeedHeader                  at offset 0, 64 bytes
+//   FeedSlot + payload          slotCount slots of slotSize bytes each,
+//   ...                         from offset headerSize
+//
+// Record n (counted from 0 since gokit opened the feed) goes into slot
+// n % slotCount. head is the number of records published, a slot holding
+// record n has seq == 2 * (n + 1) once complete and an odd seq while it is
+// being written. Payloads:
+//
+//   FR_DSOMetadata  DSOMetadata as in protocol.h (packed)
+//   FR_DSOBlock     FeedBlock followed by `count` float samples, decoded in
+//                   the capture unit, `offset` is the index of the first one
+//                   in the capture announced by the last FR_DSOMetadata
+//   FR_MMReading    MMReading as in protocol.h (packed)
+//
+// The slot ns of a FR_DSOBlock is the time of its first sample, the one of
+// a FR_MMReading the time of the reading, both corrected for the BLE
+// latency and the device clock drift (sampleclock.h).
+//
+// To follow the feed: start from head, for record n read the slot seq
+// (acquire), use the payload in place or copy it, then read seq again; a
+// changed seq, or one past 2 * (n + 1), means the writer lapped the reader
+// and the record is lost. The writer never waits for readers, a slow one
+// only loses records, it can't stall the acquisition.
+
+#define feed_magic "GKLF"
+#define feed_version 1
+#define feed_slot_size 384u  // header included
+#define feed_slot_count 4096u
+
+enum FeedRecordType : uint8_t
+{
+    FR_DSOMetadata = 0,
+    FR_DSOBlock    = 1,
+    FR_MMReading   = 2,
+};
+
+#pragma pack(push, 1)
+struct FeedBlock
+{
+    uint32_t offset;
+    uint32_t count;
+};
+#pragma pack(pop)
+
+struct FeedHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;  // offset of slot 0
+    uint32_t slotSize;
+    uint32_t slotCount;
+    uint64_t startEpochNs;       // wall clock of ns = 0
+    std::atomic<uint64_t> head;  // records published
+    uint8_t reserved[32];
+};
+
+struct FeedSlot
+{
+    std::atomic<uint64_t> seq;
+    uint64_t ns;  // monotonic, since the feed was opened (see LiveFeed::publish)
+    FeedRecordType type;
+    uint8_t reserved;
+    uint16_t size;  // of the payload
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(FeedHeader) == 64, "FeedHeader is part of the feed layout");
+static_assert(sizeof(FeedSlot) == 24, "FeedSlot is part of the feed layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the feed needs lock-free 64 bit atomics");
+
+#define feed_payload_max (feed_slot_size - sizeof(FeedSlot))
+
+// Feed writer, single producer (the GUI thread). Publishing is a clock
+// read and a memcpy into the mapped slot.
+class LiveFeed
+{
+   public:
+    LiveFeed();
+    ~LiveFeed();
+
+    LiveFeed(const LiveFeed&)            = delete;
+    LiveFeed& operator=(const LiveFeed&) = delete;
+
+    // creates (or replaces) the shm object `name`, e.g. "/gokit"
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    // payloads longer than feed_payload_max are truncated. `t` is the time
+    // of the record in steady clock seconds, the corrected sample time of
+    // DSO blocks and MM readings (sampleclock.h), 0 for the publish time
+    void publish(FeedRecordType type, const void* data, uint32_t size, double t = 0.0);
+
+    // `n` decoded samples from sample `offset` of the capture, split over
+    // as many records as needed, `t` is the time of the first one
+    void block(uint32_t offset, const float* x, uint32_t n, double t = 0.0, double period = 0.0);
+
+    uint64_t published() const { return m_next; }
+
+   private:
+    std::string m_name;
+    FeedHeader* m_header;
+    size_t m_size;
+    uint64_t m_next;
+    uint64_t m_start;
+};
+
+// Feed reader, for consumer processes (see gokit-feedtail)
+class LiveFeedReader
+{
+   public:
+    LiveFeedReader();
+    ~LiveFeedReader();
+
+    LiveFeedReader(const LiveFeedReader&)            = delete;
+    LiveFeedReader& operator=(const LiveFeedReader&) = delete;
+
+    // maps the feed read only and starts from the newest record
+    bool open(const std::string& name, std::string* error = nullptr);
+    void close();
+
+    // copies the next record, false when there is none yet
+    bool next(FeedSlot& slot, std::vector<uint8_t>& payload);
+
+    uint64_t lost() const { return m_lost; }  // records overwritten before being read
+
+   private:
+    const FeedHeader* m_header;
+    size_t m_size;
+    uint64_t m_next;
+    uint64_t m_lost;
+};
+
+#endif  // LIVEFEED_H
@@ -1,10 +1,10 @@
 #include "mainwindow.h"
 
-#include <QApplication>
+#include "application.h"
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    Application a(argc, argv);
     MainWindow w;
     w.show();
     return a.exec();
@@ -3,71 +3,156 @@
 #include <blewrapper/service.h>
 
 #include "./ui_mainwindow.h"
+#include "application.h"
+#include "ranges.h"
 
-#define DEBUG_FLAG false
-
-#define max_battery_volt 4.2f
+#include <QDateTime>
+#include <QDir>
+#include <QShortcut>
+#include <QStatusBar>
 
-#define pokit_status_service "57D3A771-267C-4394-8872-78223E92AEC5"  // wrong doc (it mentions ..C4)
-#define pokit_device_ch "6974F5E5-0E54-45C3-97DD-29E4B5FB0849"
-#define pokit_status_ch "3dba36e1-6120-4706-8dfd-ed9c16e569b6"
-#define pokit_flashled_ch "ec9bb1f3-05a9-4277-8dd0-60a7896f0d6e"
-#define pokit_torch_ch "aaf3f6d5-43d4-4a83-9510-dff3d858d4cc"   // subscr
-#define pokit_button_ch "8fe5b5a9-b5b4-4a7b-8ff2-87224b970f89"  // subscr
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
-// to confirm:
-#define pokit_multimeter_service "e7481d2f-5781-442e-bb9a-fd4e3441dadc"
-#define pokit_multimeter_setting_ch "53dc9a7a-bc19-4280-b76b-002d0e23b078"
-#define pokit_multimeter_reading_ch "047d3559-8bee-423a-b229-4417fa603b90"  // subsc
+#define DEBUG_FLAG false
 
-#define pokit_dso_service "1569801e-1425-4a7a-b617-a4f4ed719de6"
-#define pokit_dso_setting_ch "a81af1b6-b8b3-4244-8859-3da368d2be39"
-#define pokit_dso_metadata_ch "970f00ba-f46f-4825-96a8-153a5cd0cda9"
-#define pokit_dso_reading_ch "98e14f8e-536e-4f24-b4f4-1debfed0a99e"
+#define max_battery_volt 4.2f
 
 #define mm_update_interval 200u
 
-#define BUF_FROM_STRUCT(STRUCT) ::blew::Buffer(&STRUCT, sizeof(STRUCT))
-#define PRINT(str, ...) fprintf(stderr, str "\n", ##__VA_ARGS__)
-#define DEBUG_BUFFER(ch, b)                                             \
-    {                                                                   \
-        uint8_t* debugptr = b.buffer;                                   \
-        PRINT("ch %s, size %u", ch.toString().c_str(), b.size);         \
-        for (int i = 0; i < b.size; i++) PRINT("%#04hhx", debugptr[i]); \
-        PRINT("end");                                                   \
-    }
+#define timer_resolution_ms 50u
+#define rx_timeout_ms 500u
+#define stats_interval_ms 1000u
+#define alarm_blink_ms 250u
+#define picker_delay_ms 250u  // coalesces the picker rebuilds while the ranking keeps changing
+#define scan_timeout_ms 30000u
+#define profile_store_delay_ms 2000u  // at most one QSettings write per delay while settings change
+
+// goes to the trace file when tracing (GOKIT_TRACE=<file>), to stderr otherwise
+#define PRINT(str, ...)                                        \
+    (m_trace.isOpen() ? m_trace.note(str, ##__VA_ARGS__)       \
+                      : (void)fprintf(stderr, str "\n", ##__VA_ARGS__))
 
 #define DSO_H_DIVISION_N 5
 #define DSO_V_DIVISION_N 3
 
 //=============================================================================
+static double _monoSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+//=============================================================================
+// blew::Central is a base and is brought up first: the adapter power-on runs
+// on its own queue while the widgets are built, its state change (scan
+// ready) is delivered once the event loop runs
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
       blew::Central(false),
       ui(new Ui::MainWindow),
       m_peripheral(nullptr),
-      m_scanTimer(this),
-      m_mmrxTimer(this),
-      m_dsorxTimer(this),
-      m_dsoScale(1.0f),
-      m_dsoCmd(DSOC_FallingEdge)
+      m_wheel(timer_resolution_ms, this),
+      m_scanTimer(m_wheel.add([this]() { _onScanTimerTimeout(); })),
+      m_mmrxTimer(m_wheel.add([this]() { _onMMRxTimerTimeout(); })),
+      m_dsorxTimer(m_wheel.add([this]() { _onDSORxTimerTimeout(); })),
+      m_statsTimer(m_wheel.add([this]() { _onStatsTimerTimeout(); })),
+      m_pickerTimer(m_wheel.add([this]() { _rebuildPicker(); })),
+      m_dsoHoldoffTimer(m_wheel.add([this]() { _onDSOHoldoffTimeout(); })),
+      m_alarmBlinkTimer(m_wheel.add([this]() { _onAlarmBlink(); })),
+      m_profileTimer(m_wheel.add([this]() { _storeProfile(); })),
+      m_dsoCmd(DSOC_FallingEdge),
+      m_dsoRunning(false),
+      m_rxTime(0.0),
+      m_mathPeak(0.0f),
+      m_alarmBlink(false),
+      m_maskEnabled(false),
+      m_hostAutorange(false),
+      m_acquire(AQ_Normal),
+      m_decodeStats{},
+      m_lastLabelStats{},
+      m_labelRate{},
+      m_fwLabel([](const uint16_t& v) { return QString("%1.%2").arg(v >> 8).arg(v & 0xff); }, 3),
+      m_maxVoltLabel([](const uint16_t& v) { return QString("%1 V").arg(v); }, 2),
+      m_maxCurrentLabel([](const uint16_t& v) { return QString("%1 A").arg(v); }, 2),
+      m_maxResistanceLabel([](const uint16_t& v) { return QString("%1 KOhm").arg(v); }, 2),
+      m_maxSampleRateLabel([](const uint16_t& v) { return QString("%1 KHz").arg(v); }, 2),
+      m_bufSizeLabel([](const uint16_t& v) { return QString::number(v); }),
+      m_macAddrLabel(_macToStr, 7),
+      m_statusLabel(_textToStr),
+      m_batteryLabel([](const float& v) { return QString("%1V").arg(v); }, 2),
+      m_modeSwitchLabel(_textToStr),
+      m_mmrangeLabel(_textToStr),
+      m_mmmodeLabel(_textToStr),
+      m_dsosamplingrateLabel([](const uint32_t& v) { return QString::number(v); }),
+      m_dsosamplesLabel([](const uint32_t& v) { return QString::number(v); }),
+      m_dsowindowLabel([](const uint32_t& v) { return QString::number(v); }),
+      m_dsomodeLabel(_textToStr),
+      m_dsorangeLabel(_textToStr),
+      m_runtimeLabel(_runtimeToStr),
+      m_lastModeSwitch(0xff),
+      m_perfOverlay(nullptr),
+      m_replay(nullptr),
+      m_profile(DeviceCache::emptyProfile()),
+      m_firstSampleMs(-1),
+      m_firstPaintMs(-1),
+      m_scanReadyMs(-1),
+      m_dsoPageMs(-1.0),
+      m_link(&m_wheel, this),
+      m_writes(&m_wheel),
+      m_sequencer(&m_wheel),
+      m_automation(&m_sequencer, this),
+      m_appliedSlowdown(1.0f),
+      m_scopeView(this),
+      m_mathView(this),
+      m_lastScopeStats{},
+      m_scopeRate{}
 {
     ui->setupUi(this);
 
+    m_scopeView.attach(ui->oscilloscope);
+    m_mathView.attach(ui->mathOscilloscope);
+
+    if (qEnvironmentVariableIsSet("GOKIT_TRACE") && !m_trace.open(qgetenv("GOKIT_TRACE").toStdString()))
+        PRINT("unable to open trace file %s", qgetenv("GOKIT_TRACE").constData());
+
+    if (qEnvironmentVariableIsSet("GOKIT_FEED") && !m_feed.open(qgetenv("GOKIT_FEED").toStdString()))
+        PRINT("unable to open live feed %s", qgetenv("GOKIT_FEED").constData());
+
+    // GOKIT_BATTERY_CUTOFF=<volts>, the runtime projection target for cells other than the Li-ion one
+    if (qEnvironmentVariableIsSet("GOKIT_BATTERY_CUTOFF"))
+        m_battery.setCutoff(qgetenv("GOKIT_BATTERY_CUTOFF").toFloat());
+
+    m_perfOverlay = new PerfOverlay(ui->centralwidget);
+
+    m_fwLabel.attach(ui->firmwareVerLabel);
+    m_maxVoltLabel.attach(ui->maxVoltLabel);
+    m_maxCurrentLabel.attach(ui->maxCurrentLabel);
+    m_maxResistanceLabel.attach(ui->maxResistanceLabel);
+    m_maxSampleRateLabel.attach(ui->maxSampleRateLabel);
+    m_bufSizeLabel.attach(ui->bufSizeLabel);
+    m_macAddrLabel.attach(ui->macAddrLabel);
+    m_statusLabel.attach(ui->statusLabel);
+    m_batteryLabel.attach(ui->batteryLabel);
+    m_modeSwitchLabel.attach(ui->modeSwitchLabel);
+    m_mmrangeLabel.attach(ui->mmrangeLabel);
+    m_mmmodeLabel.attach(ui->mmmodeLabel);
+    m_dsosamplingrateLabel.attach(ui->dsosamplingrateLabel);
+    m_dsosamplesLabel.attach(ui->dsosamplesLabel);
+    m_dsowindowLabel.attach(ui->dsowindowLabel);
+    m_dsomodeLabel.attach(ui->dsomodeLabel);
+    m_dsorangeLabel.attach(ui->dsorangeLabel);
+    m_runtimeLabel.attach(ui->runtimeLabel);
+
     ui->batteryIndicator->setRoundedBar();
 
     ui->mmvalue->setDigitsNum(6, 3);
     ui->mmvalue->setAutoMinus(false);
 
     ui->mmrangeSelector->setArrayDir(gui::AD_Vertical);
-    ui->dsoRangeSelector->setArrayDir(gui::AD_Vertical);
 
     ui->torchButton->setAutoMode(false);
     ui->torchButton->setActiveText("ON");
 
-    ui->dsotriggerButton->setAutoMode(false);
-    ui->dsotriggerButton->setActiveText("RUNNING");
-
     gui::UltraEntry e{};
     e.text = "Multimeter";
     e.data = ui->stack_multimeterPage;
@@ -86,88 +171,13 @@ MainWindow::MainWindow(QWidget* parent)
     ui->deviceModeSelector->addEntry(e);
     //
 
-    e = {};
-
-    e.text = "Idle";
-    e.id   = MM_IDLE;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "DC Voltage";
-    e.id   = MM_DCVoltage;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "AC Voltage";
-    e.id   = MM_ACVoltage;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "DC Current";
-    e.id   = MM_DCCurrent;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "AC Current";
-    e.id   = MM_ACCurrent;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "Resistance";
-    e.id   = MM_Resistance;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "Diode";
-    e.id   = MM_Diode;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "Continuity";
-    e.id   = MM_Continuity;
-    ui->mmModeSelector->addEntry(e);
-
-    e.text = "Temperature";
-    e.id   = MM_Temperature;
-    ui->mmModeSelector->addEntry(e);
-
-    //
-
-    e = {};
-
-    e.text = "Falling edge";
-    e.id   = DSOC_FallingEdge;
-    ui->dsoModeSelector->addEntry(e, true);
-
-    e.text = "Rising edge";
-    e.id   = DSOC_RisingEdge;
-    ui->dsoModeSelector->addEntry(e);
-
-    e.text = "Continuos";
-    e.id   = DSOC_Continuos;
-    ui->dsoModeSelector->addEntry(e);
-
-    e.text = "Free running";
-    e.id   = DSOC_FreeRunning;
-    ui->dsoModeSelector->addEntry(e);
-
-    //
-
-    e = {};
-
-    e.text = "DC Voltage";
-    e.id   = DOM_VDC;
-    ui->dsoMeasureSelector->addEntry(e, true);
-
-    e.text = "AC Voltage";
-    e.id   = DOM_VAC;
-    ui->dsoMeasureSelector->addEntry(e);
-
-    e.text = "DC Current";
-    e.id   = DOM_ADC;
-    ui->dsoMeasureSelector->addEntry(e);
-
-    e.text = "AC Current";
-    e.id   = DOM_AAC;
-    ui->dsoMeasureSelector->addEntry(e);
+    _fillMMModeSelector();
 
     //
 
+    // only the multimeter page, the one shown at startup, is filled here; the
+    // oscilloscope page is set up when first needed (_setupDSOPage)
     _setupMMRangeSelector(MM_IDLE);
-    _setupDSORangeSelector(DOM_VDC);
 
     // clang-format off
     connect(ui->deviceModeSelector, SIGNAL(onClickForStacked(QWidget*)), ui->stackedWidget,
@@ -179,42 +189,91 @@ MainWindow::MainWindow(QWidget* parent)
     connect(ui->mmModeSelector, SIGNAL(onClick(int32_t,void*)), this,
             SLOT(_onMultimeterModeChange(int32_t,void*)));
 
-    connect(ui->dsoModeSelector, SIGNAL(onClick(int32_t,void*)), this,
-            SLOT(_onDSOModeChange(int32_t,void*)));
-
-    connect(ui->dsoMeasureSelector, SIGNAL(onClick(int32_t,void*)), this,
-            SLOT(_onDSOMeasureChange(int32_t,void*)));
-
     connect(ui->mmrangeSelector, SIGNAL(onClick(const gui::UltraEntry*)), this,
             SLOT(_onMultimeterRangeSelectorPress(const gui::UltraEntry*)));
 
-    connect(ui->dsoRangeSelector, SIGNAL(onClick(const gui::UltraEntry*)), this,
-            SLOT(_onDSORangeSelectorPress(const gui::UltraEntry*)));
-
     connect(ui->scanButton, SIGNAL(onClick()), this, SLOT(_onScanButtonClick()));
 
-    connect(&m_scanTimer, SIGNAL(timeout()), this, SLOT(_onScanTimerTimeout()));
-    connect(&m_mmrxTimer, SIGNAL(timeout()), this, SLOT(_onMMRxTimerTimeout()));
-    connect(&m_dsorxTimer, SIGNAL(timeout()), this, SLOT(_onDSORxTimerTimeout()));
+    connect(ui->targetRuntimeSpin, SIGNAL(valueChanged(int)), this, SLOT(_onTargetRuntimeChange(int)));
 
     connect(ui->connectionSelector, SIGNAL(onPick(const gui::UltraEntry*)), this,
             SLOT(_deviceSelected(const gui::UltraEntry*)));
 
     connect(ui->connectButton, SIGNAL(onClick()), this, SLOT(_onConnectButtonClick()));
 
+    connect(&m_link, SIGNAL(reconnectAttempt(QString)), this, SLOT(_onReconnectAttempt(QString)));
+    connect(&m_link, SIGNAL(linkLost()), this, SLOT(_onLinkLost()));
+    connect(&m_link, SIGNAL(linkRestored(qint64)), this, SLOT(_onLinkRestored(qint64)));
+
     connect(ui->torchButton, SIGNAL(onChange(bool)), this, SLOT(_onTorchButtonChange(bool)));
 
-    connect(ui->dsotriggerButton, SIGNAL(onChange(bool)), this, SLOT(_onDsoTriggerButtonChange(bool)));
+    connect(new QShortcut(QKeySequence(Qt::Key_F12), this), SIGNAL(activated()), this, SLOT(_onPerfOverlayToggle()));
     // clang-format on
 
-    m_mmrxTimer.setSingleShot(true);
-    m_mmrxTimer.setInterval(500);
+    m_wheel.start(m_statsTimer, stats_interval_ms, true);
+
+    // GOKIT_ALARMS=<rules file>, syntax in alarms.h
+    if (qEnvironmentVariableIsSet("GOKIT_ALARMS"))
+    {
+        QByteArray path = qgetenv("GOKIT_ALARMS");
+        std::vector<std::string> errors;
+
+        int n = m_alarms.load(path.toStdString(), &errors);
+        for (const std::string& e : errors) PRINT("alarms: %s", e.c_str());
+        PRINT("alarms: %d rules loaded from %s", n, path.constData());
+    }
+    m_alarms.setHandler([this](const AlarmEvent& e) { _onAlarm(e); });
+
+    m_writes.setWriter(
+        [this](PokitChar ch, const uint8_t* data, uint32_t size)
+        {
+            if (!m_peripheral) return false;
+            auto c = m_peripheral->characteristic_r(pokitCharUuid(ch));
+            if (!c) return false;
+
+            m_trace.record(TR_Write, ch, data, size);
+            c->writeValue(blew::Buffer(data, size));
+            return true;
+        });
+
+    // plans write through the same path as the GUI selectors
+    m_sequencer.setWriters([this](const MMSettings& s) { _writeMMSettings(s); },
+                           [this](const DSOSettings& s) { _writeDSOSettings(s); });
+
+    // GOKIT_API=<local socket name>, plan syntax in sequencer.h
+    if (qEnvironmentVariableIsSet("GOKIT_API") && !m_automation.listen(qgetenv("GOKIT_API")))
+        PRINT("unable to listen on %s", qgetenv("GOKIT_API").constData());
+
+    // GOKIT_MASK=<mask file>, syntax in masktest.h; GOKIT_MASK_FAILS=<dir>
+    m_maskFailDir = qEnvironmentVariableIsSet("GOKIT_MASK_FAILS") ? qgetenv("GOKIT_MASK_FAILS") : "mask_fails";
+    if (qEnvironmentVariableIsSet("GOKIT_MASK"))
+    {
+        std::string error;
+        if (!m_mask.load(qgetenv("GOKIT_MASK").toStdString(), DSO_H_DIVISION_N, &error))
+            PRINT("mask: %s", error.c_str());
+    }
+    _updateMaskStats();
 
-    m_dsorxTimer.setSingleShot(true);
-    m_dsorxTimer.setInterval(500);
+    // GOKIT_REPLAY=<trace> [GOKIT_REPLAY_SPEED=<factor, 0 = as fast as possible>]
+    if (qEnvironmentVariableIsSet("GOKIT_REPLAY"))
+    {
+        QByteArray path = qgetenv("GOKIT_REPLAY");
+        double speed    = 1.0;
+        if (qEnvironmentVariableIsSet("GOKIT_REPLAY_SPEED")) speed = qgetenv("GOKIT_REPLAY_SPEED").toDouble();
+
+        m_replay = new TraceReplay(this, this);
+        if (m_replay->load(path.toStdString()))
+            m_replay->start(speed);
+        else
+            PRINT("unable to load replay trace %s", path.constData());
+    }
 }
 //=============================================================================
-MainWindow::~MainWindow() { delete ui; }
+MainWindow::~MainWindow()
+{
+    if (m_wheel.isActive(m_profileTimer)) _storeProfile();
+    delete ui;
+}
 //=============================================================================
 MultimeterMode MainWindow::_currentMMMode()
 {
@@ -229,7 +288,7 @@ uint8_t MainWindow::_currentMMRange()
     if (ui->mmrangeSelector->current())
         return (uint8_t)ui->mmrangeSelector->current()->id;
     else
-        return 255;  // autorange
+        return range_auto;
 }
 //=============================================================================
 uint8_t MainWindow::_currentDSORange()
@@ -256,86 +315,79 @@ DSOOpMode MainWindow::_currentDSOMode()
         return DOM_Idle;
 }
 //=============================================================================
-QString MainWindow::_modeswToStr(ModeSwitchPosition mode)
+const char* MainWindow::_modeswToStr(ModeSwitchPosition mode)
 {
-    switch (mode)
-    {
-        case MSP_Voltage:
-            return "Voltage";
-        case MSP_Mixed:
-            return "Mixed";
-        case MSP_Current:
-            return "Current";
-    }
-
-    return "";
+    static const char* names[] = {"Voltage", "Mixed", "Current"};
+    return (uint8_t)mode <= MSP_Current ? names[mode] : "";
+}
+//=============================================================================
+const char* MainWindow::_devstateToStr(DeviceState state)
+{
+    static const char* names[] = {
+        "Idle",          "MM DC Voltage", "MM AC Voltage",  "MM DC Current", "MM AC Current", "MM Resistance",
+        "MM Diode",      "MM Continuity", "MM Temperature", "Oscilloscope",  "Datalogger",
+    };
+    return (uint8_t)state <= DS_Datalogger ? names[state] : "";
+}
+//=============================================================================
+QString MainWindow::_textToStr(const char* const& text) { return QString::fromLatin1(text); }
+//=============================================================================
+// minutes left (< 0 unknown), slowdown x10
+QString MainWindow::_runtimeToStr(const std::pair<int32_t, int32_t>& r)
+{
+    QString s("--");
+    if (r.first >= 0) s = QString("%1h %2m").arg(r.first / 60).arg(r.first % 60, 2, 10, QChar('0'));
+    if (r.second > 10) s += QString(" (x%1 slower)").arg(r.second / 10.0, 0, 'f', 1);
+    return s;
+}
+//=============================================================================
+QString MainWindow::_macToStr(const std::array<uint8_t, 6>& mac)
+{
+    return QString("%1:%2:%3:%4:%5:%6")
+        .arg((ushort)mac[0], 2, 16, (QChar)'0')
+        .arg((ushort)mac[1], 2, 16, (QChar)'0')
+        .arg((ushort)mac[2], 2, 16, (QChar)'0')
+        .arg((ushort)mac[3], 2, 16, (QChar)'0')
+        .arg((ushort)mac[4], 2, 16, (QChar)'0')
+        .arg((ushort)mac[5], 2, 16, (QChar)'0');
 }
 //=============================================================================
 void MainWindow::_updateDevData(const DeviceData& data)
 {
-    ui->firmwareVerLabel->setText(QString("%1.%2").arg(data.fwMaj).arg(data.fwMin));
-    ui->maxVoltLabel->setText(QString("%1 V").arg(data.maxVoltage));
-    ui->maxCurrentLabel->setText(QString("%1 A").arg(data.maxCurrent));
-    ui->maxResistanceLabel->setText(QString("%1 KOhm").arg(data.maxResistance));
-    ui->maxSampleRateLabel->setText(QString("%1 KHz").arg(data.maxSamplingRate));
-    ui->bufSizeLabel->setText(QString("%1").arg(data.maxBufferSize));
-    ui->macAddrLabel->setText(QString("%1:%2:%3:%4:%5:%6")
-                                  .arg((ushort)data.macAddr[0], 2, 16, (QChar)'0')
-                                  .arg((ushort)data.macAddr[1], 2, 16, (QChar)'0')
-                                  .arg((ushort)data.macAddr[2], 2, 16, (QChar)'0')
-                                  .arg((ushort)data.macAddr[3], 2, 16, (QChar)'0')
-                                  .arg((ushort)data.macAddr[4], 2, 16, (QChar)'0')
-                                  .arg((ushort)data.macAddr[5], 2, 16, (QChar)'0'));
+    PERF_SCOPE(PS_Widget);
+
+    std::array<uint8_t, 6> mac;
+    std::copy(std::begin(data.macAddr), std::end(data.macAddr), mac.begin());
+
+    m_fwLabel.set(uint16_t(data.fwMaj << 8 | data.fwMin));
+    m_maxVoltLabel.set(data.maxVoltage);
+    m_maxCurrentLabel.set(data.maxCurrent);
+    m_maxResistanceLabel.set(data.maxResistance);
+    m_maxSampleRateLabel.set(data.maxSamplingRate);
+    m_bufSizeLabel.set(data.maxBufferSize);
+    m_macAddrLabel.set(mac);
 }
 //=============================================================================
 void MainWindow::_updateDevStatus(const DeviceStatus& status)
 {
-    QString stateStr;
-
-    switch (status.state)
-    {
-        case DS_MM_Idle:
-            stateStr = "Idle";
-            break;
-        case DS_MM_DCVoltage:
-            stateStr = "MM DC Voltage";
-            break;
-        case DS_MM_ACVoltage:
-            stateStr = "MM AC Voltage";
-            break;
-        case DS_MM_DCCUrrent:
-            stateStr = "MM DC Current";
-            break;
-        case DS_MM_ACCurrent:
-            stateStr = "MM AC Current";
-            break;
-        case DS_MM_Resistance:
-            stateStr = "MM Resistance";
-            break;
-        case DS_MM_Diode:
-            stateStr = "MM Diode";
-            break;
-        case DS_MM_Continuity:
-            stateStr = "MM Continuity";
-            break;
-        case DS_MM_Temperature:
-            stateStr = "MM Temperature";
-            break;
-        case DS_DSO:
-            stateStr = "Oscilloscope";
-            break;
-        case DS_Datalogger:
-            stateStr = "Datalogger";
-            break;
-    }
+    PERF_SCOPE(PS_Widget);
 
-    ui->statusLabel->setText(stateStr);
+    m_statusLabel.set(_devstateToStr(status.state));
 
     ui->batteryIndicator->setProgressBar(int((status.batteryVoltage / max_battery_volt) * 1000.0f));
-    ui->batteryLabel->setText(QString("%1V").arg(status.batteryVoltage));
+    m_batteryLabel.set(status.batteryVoltage);
 
-    ui->modeSwitchLabel->setText(_modeswToStr(status.modeswitch));
-    _setupMMModeSelector(status.modeswitch);
+    m_battery.addSample(_monoSeconds(), status.batteryVoltage);
+    _applyBatterySchedule();
+
+    m_modeSwitchLabel.set(_modeswToStr(status.modeswitch));
+
+    // regraying the selector is only needed when the physical switch moves
+    if (status.modeswitch != m_lastModeSwitch)
+    {
+        m_lastModeSwitch = status.modeswitch;
+        _setupMMModeSelector(status.modeswitch);
+    }
 
 #if DEBUG_FLAG == true
     PRINT("spare 0 %#04hhx", status.spare0);
@@ -343,26 +395,52 @@ void MainWindow::_updateDevStatus(const DeviceStatus& status)
 #endif
 }
 //=============================================================================
+void MainWindow::_applyBatterySchedule()
+{
+    double runtime = m_battery.projectedRuntime();
+    float slowdown = m_battery.slowdown();
+
+    m_runtimeLabel.set({runtime < 0.0 ? -1 : int(runtime / 60.0), int(slowdown * 10.0f + 0.5f)});
+
+    if (slowdown == m_appliedSlowdown) return;
+    m_appliedSlowdown = slowdown;
+
+    // the DSO picks the new holdoff up at the end of the current capture
+    if (_currentMMMode() != MM_IDLE) _updateDeviceMMMode();
+}
+//=============================================================================
 void MainWindow::_updateDeviceMMMode()
 {
-    if (!m_peripheral) return;
-    auto c = m_peripheral->characteristic_r(pokit_multimeter_setting_ch);
-    if (!c) return;
+    if (m_sequencer.busy()) return;  // a plan owns the settings
 
     MMSettings mmsettings = {};
 
     mmsettings.mode           = _currentMMMode();
-    mmsettings.range          = _currentMMRange();
-    mmsettings.updateInterval = mm_update_interval;
+    mmsettings.range          = m_hostAutorange ? m_autorange.range() : _currentMMRange();
+    mmsettings.updateInterval = m_battery.mmInterval(mm_update_interval);
 
-    c->writeValue(BUF_FROM_STRUCT(mmsettings));
+    _writeMMSettings(mmsettings);
 }
 //=============================================================================
-void MainWindow::_updateDeviceDSOMode(bool stop)
+void MainWindow::_writeMMSettings(const MMSettings& settings)
 {
     if (!m_peripheral) return;
-    auto c = m_peripheral->characteristic_r(pokit_dso_setting_ch);
-    if (!c) return;
+
+    MMSettings s = settings;
+    m_writes.write(PC_MMSetting, &s, sizeof(s));
+    m_mmClock.setInterval(s.updateInterval / 1000.0);
+
+    m_profile.mm         = s;
+    m_profile.hasMM      = true;
+    m_profile.mmSelected = m_sequencer.busy() ? s.range : _currentMMRange();  // PRED writes fixed ranges
+    _profileChanged();
+}
+//=============================================================================
+// `remember` false leaves the profile on the previous settings (battery holdoff)
+void MainWindow::_updateDeviceDSOMode(bool stop, bool remember)
+{
+    if (m_sequencer.busy()) return;
+    _setupDSOPage();
 
     DSOSettings settings = {};
 
@@ -373,14 +451,107 @@ void MainWindow::_updateDeviceDSOMode(bool stop)
     settings.window  = 100000;  // to set
     settings.samples = 1000;    // to set
 
+    m_equivalent.setTrigger(settings.trigger, settings.command == DSOC_RisingEdge);
+
+#if DEBUG_FLAG == true
     PRINT("command %u", settings.command);
     PRINT("trigger %f", settings.trigger);
     PRINT("mode %u", settings.mode);
     PRINT("range %u", settings.range);
     PRINT("window %u", settings.window);
     PRINT("samples %u", settings.samples);
+#endif
+
+    _writeDSOSettings(settings, remember);
+}
+//=============================================================================
+void MainWindow::_writeDSOSettings(const DSOSettings& settings, bool remember)
+{
+    if (!m_peripheral) return;
+
+    DSOSettings s = settings;
+    m_writes.write(PC_DSOSetting, &s, sizeof(s));
+    if (!remember) return;
+
+    m_profile.dso    = s;
+    m_profile.hasDSO = true;
+    _profileChanged();
+}
+//=============================================================================
+void MainWindow::_profileChanged()
+{
+    if (!m_wheel.isActive(m_profileTimer)) m_wheel.start(m_profileTimer, profile_store_delay_ms);
+}
+//=============================================================================
+void MainWindow::_storeProfile()
+{
+    m_wheel.stop(m_profileTimer);
+    m_cache.store(m_peripheralUuid, m_profile);
+}
+//=============================================================================
+// the restored settings, shown on the selectors as if picked by the user
+void MainWindow::_showMMSettings(const MMSettings& settings, uint8_t selected)
+{
+    _fillMMModeSelector(settings.mode);
+    _setupMMRangeSelector(settings.mode, selected);
+    _restartAutoRange();
+}
+//=============================================================================
+void MainWindow::_showDSOSettings(const DSOSettings& settings)
+{
+    _setupDSOPage();
+    _fillDSOSelectors(settings.command, settings.mode);
+    _setupDSORangeSelector(settings.mode, settings.range);
+    m_equivalent.setTrigger(settings.trigger, settings.command == DSOC_RisingEdge);
+
+    // resumed running, as if started with the trigger button (battery holdoff included)
+    m_dsoRunning = settings.mode != DOM_Idle;
+    ui->dsotriggerButton->setState(m_dsoRunning);
+}
+//=============================================================================
+// the selectors can only select while being filled, so they are refilled
+void MainWindow::_fillMMModeSelector(int current)
+{
+    ui->mmModeSelector->clear();
+
+    gui::UltraEntry e{};
+    for (uint8_t m = 0; m < mmModeCount; m++)
+    {
+        e.text = mmModes[m].name;
+        e.id   = m;
+        ui->mmModeSelector->addEntry(e, m == current);
+    }
+
+    _setupMMModeSelector((ModeSwitchPosition)m_lastModeSwitch);
+}
+//=============================================================================
+void MainWindow::_fillDSOSelectors(DSOCommand command, DSOOpMode mode)
+{
+    static const std::pair<DSOCommand, const char*> commands[] = {
+        {DSOC_FallingEdge, "Falling edge"},
+        {DSOC_RisingEdge, "Rising edge"},
+        {DSOC_Continuos, "Continuos"},
+        {DSOC_FreeRunning, "Free running"},
+    };
+
+    ui->dsoModeSelector->clear();
+    ui->dsoMeasureSelector->clear();
+
+    gui::UltraEntry e{};
+    for (const auto& c : commands)
+    {
+        e.text = c.second;
+        e.id   = c.first;
+        ui->dsoModeSelector->addEntry(e, c.first == command);
+    }
 
-    c->writeValue(BUF_FROM_STRUCT(settings));
+    e = {};
+    for (uint8_t m = DOM_VDC; m < dsoModeCount; m++)
+    {
+        e.text = dsoModes[m].name;
+        e.id   = m;
+        ui->dsoMeasureSelector->addEntry(e, m == mode);
+    }
 }
 //=============================================================================
 void MainWindow::_setupMMModeSelector(ModeSwitchPosition sw)
@@ -410,249 +581,119 @@ void MainWindow::_setupMMModeSelector(ModeSwitchPosition sw)
     }
 }
 //=============================================================================
-void MainWindow::_setupMMRangeSelector(MultimeterMode mode)
+void MainWindow::_setupMMRangeSelector(MultimeterMode mode, int current)
 {
     ui->mmrangeSelector->clear();
 
-    switch (mode)
-    {
-        case MM_DCVoltage:
-        case MM_ACVoltage:
-            ui->rangeSetupFrame->setVisible(true);
-            ui->mmrangeSelector->addButton({"0~300mV", 0});
-            ui->mmrangeSelector->addButton({"300mV~2V", 1});
-            ui->mmrangeSelector->addButton({"2V~6V", 2});
-            ui->mmrangeSelector->addButton({"6V~12V", 3});
-            ui->mmrangeSelector->addButton({"12V~30V", 4});
-            ui->mmrangeSelector->addButton({"30V~60V", 5});
-            ui->mmrangeSelector->addButton({"AUTO", 255});
-            break;
-
-        case MM_DCCurrent:
-        case MM_ACCurrent:
-            ui->rangeSetupFrame->setVisible(true);
-            ui->mmrangeSelector->addButton({"0~10mA", 0});
-            ui->mmrangeSelector->addButton({"10mA~30mA", 1});
-            ui->mmrangeSelector->addButton({"30mA~150mA", 2});
-            ui->mmrangeSelector->addButton({"150mA~300mA", 3});
-            ui->mmrangeSelector->addButton({"300mA~3A", 4});
-            ui->mmrangeSelector->addButton({"AUTO", 255});
-            break;
-
-        case MM_Resistance:
-            ui->rangeSetupFrame->setVisible(true);
-            ui->mmrangeSelector->addButton({"0~160R", 0});
-            ui->mmrangeSelector->addButton({"160R~330R", 1});
-            ui->mmrangeSelector->addButton({"330R~890R", 2});
-            ui->mmrangeSelector->addButton({"890R~1K5", 3});
-            ui->mmrangeSelector->addButton({"1K5~10KOhm", 4});
-            ui->mmrangeSelector->addButton({"10K~100K", 5});
-            ui->mmrangeSelector->addButton({"100R~470K", 6});
-            ui->mmrangeSelector->addButton({"470R~1M", 7});
-            ui->mmrangeSelector->addButton({"AUTO", 255});
-            break;
+    const ModeDesc& desc = mmMode(mode);
+    ui->rangeSetupFrame->setVisible(desc.rangeCount > 0);
 
-        default:
-            ui->rangeSetupFrame->setVisible(false);
-            break;
-    }
+    for (uint8_t r = 0; r < desc.rangeCount; r++)
+        ui->mmrangeSelector->addButton({desc.ranges[r].label, r}, r == current);
+    if (desc.autorange) ui->mmrangeSelector->addButton({"AUTO", range_auto}, current == range_auto);
+    if (desc.autorange) ui->mmrangeSelector->addButton({"PRED", range_predictive}, current == range_predictive);
 }
 //=============================================================================
-void MainWindow::_setupDSORangeSelector(DSOOpMode mode)
+void MainWindow::_setupDSORangeSelector(DSOOpMode mode, uint8_t current)
 {
     ui->dsoRangeSelector->clear();
 
-    switch (mode)
+    const ModeDesc& desc = dsoMode(mode);
+    if (!desc.rangeCount)
     {
-        case DOM_Idle:
-            ui->dsoRangeSelector->hide();
-            return;
-
-        case DOM_VDC:
-        case DOM_VAC:
-            // voltage
-            ui->dsoRangeSelector->addButton({"0~300mV", 0}, true);
-            ui->dsoRangeSelector->addButton({"300mV~2V", 1});
-            ui->dsoRangeSelector->addButton({"2V~6V", 2});
-            ui->dsoRangeSelector->addButton({"6V~12V", 3});
-            ui->dsoRangeSelector->addButton({"12V~30V", 4});
-            ui->dsoRangeSelector->addButton({"30V~60V", 5});
-            break;
-
-        case DOM_ADC:
-        case DOM_AAC:
-            // current
-            ui->dsoRangeSelector->addButton({"0~10mA", 0}, true);
-            ui->dsoRangeSelector->addButton({"10mA~30mA", 1});
-            ui->dsoRangeSelector->addButton({"30mA~150mA", 2});
-            ui->dsoRangeSelector->addButton({"150mA~300mA", 3});
-            ui->dsoRangeSelector->addButton({"300mA~3A", 4});
-            break;
+        ui->dsoRangeSelector->hide();
+        return;
     }
 
+    for (uint8_t r = 0; r < desc.rangeCount; r++)
+        ui->dsoRangeSelector->addButton({desc.ranges[r].label, r}, r == current);
+
     ui->dsoRangeSelector->show();
 }
 //=============================================================================
-void MainWindow::_setupDSOOscilloscope(const DSOMetadata& metadata)
+void MainWindow::_setupDSOOscilloscope(const DSOMetadata& metadata, uint32_t interleave)
 {
     float time       = metadata.window / 1000.0f;  // in milliseconds
-    float samplesize = time / metadata.samples;
+    float samplesize = time / (metadata.samples * interleave);
 
-    ui->oscilloscope->clear();
-    ui->oscilloscope->setHorizontalScale(time / (float)DSO_H_DIVISION_N, DSO_H_DIVISION_N, samplesize);
-    ui->oscilloscope->setVerticalScale(
-        _dsorangeToMax(metadata.mode, metadata.range) / (float)DSO_V_DIVISION_N, DSO_V_DIVISION_N);
+    m_scopeView.setup(time / (float)DSO_H_DIVISION_N, DSO_H_DIVISION_N, samplesize,
+                      rangeFullScale(dsoMode(metadata.mode), metadata.range) / (float)DSO_V_DIVISION_N,
+                      DSO_V_DIVISION_N);
 }
 //=============================================================================
-QString MainWindow::_mmrangeToStr(uint8_t range, MultimeterMode mode)
+// smallest 1-2-5 step not below `x`
+static float _niceDivision(float x)
 {
-    if (mode == MM_DCVoltage || mode == MM_DCVoltage) switch (range)
-        {
-            case 0:
-                return "0~300mV";
-            case 1:
-                return "300mV~2V";
-            case 2:
-                return "2V~6V";
-            case 3:
-                return "6V~12V";
-            case 4:
-                return "12V~30V";
-            case 5:
-                return "30V~60V";
-            case 255:
-                return "AUTO";
-        }
+    if (!(x > 0.0f)) return 1.0f;
 
-    else if (mode == MM_DCCurrent || mode == MM_ACCurrent)
-        switch (range)
-        {
-            case 0:
-                return "0~10mA";
-            case 1:
-                return "10mA~30mA";
-            case 2:
-                return "30mA~150mA";
-            case 3:
-                return "150mA~300mA";
-            case 4:
-                return "300mA~3A";
-            case 255:
-                return "AUTO";
-        }
-
-    else if (mode == MM_Resistance)
-        switch (range)
-        {
-            case 0:
-                return "0R~160R";
-            case 1:
-                return "160R~330R";
-            case 2:
-                return "330R~890R";
-            case 3:
-                return "890R~1K5";
-            case 4:
-                return "1K5~10K";
-            case 5:
-                return "10K~100K";
-            case 6:
-                return "100K~470K";
-            case 7:
-                return "470K~1M";
-            case 255:
-                return "AUTO";
-        }
-
-    return "---";
+    float p = powf(10.0f, floorf(log10f(x)));
+    for (float m : {1.0f, 2.0f, 5.0f})
+        if (m * p >= x) return m * p;
+    return 10.0f * p;
 }
 //=============================================================================
-QString MainWindow::_mmmodeToStr(MultimeterMode mode)
+void MainWindow::_setupMathOscilloscope()
 {
-    switch (mode)
+    const DSOMetadata& metadata   = m_capture.metadata();
+    const std::vector<float>& ref = m_math.reference();
+
+    // nothing to show: the math scope is only for math results and references
+    bool visible = m_math.op() != MO_Off || !ref.empty();
+    ui->mathOscilloscope->setVisible(visible);
+    m_mathView.clear();
+    if (!visible || !metadata.samples) return;
+
+    float time       = metadata.window / 1000.0f;  // in milliseconds
+    float samplesize = time / metadata.samples;
+
+    // math results have no fixed full scale, fit the previous capture
+    float full = rangeFullScale(dsoMode(metadata.mode), metadata.range);
+    if (m_math.op() != MO_Off && m_mathPeak > 0.0f) full = m_mathPeak;
+    m_mathView.setup(time / (float)DSO_H_DIVISION_N, DSO_H_DIVISION_N, samplesize,
+                     _niceDivision(full / (float)DSO_V_DIVISION_N), DSO_V_DIVISION_N);
+
+    // op off: the stored reference is shown, time aligned with the live capture
+    if (m_math.op() == MO_Off)
     {
-        case MM_IDLE:
-            return "Idle";
-        case MM_DCVoltage:
-            return "DC Voltage";
-        case MM_ACVoltage:
-            return "AC Voltage";
-        case MM_DCCurrent:
-            return "DC Current";
-        case MM_ACCurrent:
-            return "AC Current";
-        case MM_Resistance:
-            return "Resistance";
-        case MM_Diode:
-            return "Diode";
-        case MM_Continuity:
-            return "Continuity";
-        case MM_Temperature:
-            return "Temperature";
+        std::vector<float> r(ref.begin(), ref.begin() + std::min<size_t>(ref.size(), metadata.samples));
+        m_mathView.addBlock(r.data(), (uint32_t)r.size());
     }
-
-    return "---";
 }
 //=============================================================================
-float MainWindow::_dsorangeToMax(DSOOpMode mode, uint8_t range)
+void MainWindow::_rebuildMath()
 {
-    switch (mode)
-    {
-        case DOM_VDC:
-        case DOM_VAC:
-            switch (range)
-            {
-                case 0:
-                    return 0.3f;
-                case 1:
-                    return 2.0f;
-                case 2:
-                    return 6.0f;
-                case 3:
-                    return 12.0f;
-                case 4:
-                    return 30.0f;
-                case 5:
-                    return 60.0f;
-            }
-        case DOM_ADC:
-        case DOM_AAC:
-            switch (range)
-            {
-                case 0:
-                    return 0.01f;
-                case 1:
-                    return 0.03f;
-                case 2:
-                    return 0.15f;
-                case 3:
-                    return 0.3f;
-                case 4:
-                    return 3.0f;
-            }
+    // settings changed mid capture: evaluate what was received so far, once
+    m_mathPeak = 0.0f;
+    m_math.reset(m_capture.samplePeriod());
+    _setupMathOscilloscope();
 
-        default:
-            break;
-    }
+    if (m_math.op() == MO_Off || !m_capture.size()) return;
 
-    return 1.0f;
+    m_mathBlock.resize(std::max<size_t>(m_mathBlock.size(), m_capture.size()));
+    m_math.process(m_capture.data(), m_capture.size(), m_mathBlock.data());
+    m_mathView.addBlock(m_mathBlock.data(), m_capture.size());
 }
 //=============================================================================
-QString MainWindow::_dsorangeToStr(DSOOpMode mode, uint8_t range)
+void MainWindow::_updateCursorStats()
 {
-    switch (mode)
+    uint32_t a = m_capture.sampleAt(ui->cursorASpin->value() / 1000.0);
+    uint32_t b = m_capture.sampleAt(ui->cursorBSpin->value() / 1000.0);
+
+    WindowStats st = m_capture.window(a, b);
+    if (!st.count)
     {
-        case DOM_Idle:
-            return "Idle";
-        case DOM_VDC:
-        case DOM_VAC:
-            return "AC Voltage";
-        case DOM_ADC:
-            return "DC Current";
-        case DOM_AAC:
-            return "AC Current";
+        ui->cursorStatsLabel->setText("---");
+        return;
     }
-    return "---";
+
+    const char* unit = dsoMode(m_capture.metadata().mode).unit;
+    ui->cursorStatsLabel->setText(QString("Δt %1 ms  mean %2 %6  RMS %3 %6  ∫ %4 %6·s  E %5 %6²·s")
+                                      .arg(st.seconds * 1000.0, 0, 'g', 4)
+                                      .arg(st.mean, 0, 'g', 4)
+                                      .arg(st.rms, 0, 'g', 4)
+                                      .arg(st.integral, 0, 'g', 4)
+                                      .arg(st.energy, 0, 'g', 4)
+                                      .arg(unit));
 }
 //=============================================================================
 void MainWindow::_updateMMLeds(MultimeterMode mode, uint8_t status)
@@ -677,205 +718,510 @@ void MainWindow::_updateMMLeds(MultimeterMode mode, uint8_t status)
     }
 
     ui->mmautorangeLed->activate(autorange);
-    ui->mmerrorLed->activate(status == 255);
+    if (!m_alarms.active(AS_MMValue)) ui->mmerrorLed->activate(status == 255);  // blinking otherwise
     ui->mmcontinuityLed->activate(continuity);
 }
 //=============================================================================
 void MainWindow::_dsoReading(const DSOReading& data, uint32_t size)
 {
-    ui->dsotriggerButton->setState(true);
-    m_dsorxTimer.start();
+    PERF_SCOPE(PS_Widget);
+    _setupDSOPage();
+
+    // liveness: a timestamp store per block, the widget is touched on edges only
+    if (!m_wheel.isActive(m_dsorxTimer)) ui->dsotriggerButton->setState(true);
+    m_wheel.touch(m_dsorxTimer, rx_timeout_ms);
+
+    bool wasComplete = m_capture.complete();
+    uint32_t offset  = m_capture.size();
+    float* block     = m_capture.append(data.data, size);
+    double t         = m_dsoClock.block(offset, size, m_rxTime);
+    m_feed.block(offset, block, size, t, m_dsoClock.period());
+
+    // averaging: math and mask work on the averaged trace, the one on screen;
+    // equivalent time: the trace is drawn once the capture is interleaved
+    if (m_acquire == AQ_Average) block = m_average.block(block, offset, size);
+    if (m_acquire != AQ_EquivalentTime) m_scopeView.addBlock(block, size);
+
+    // math channel: only the new block is evaluated, never the whole capture
+    if (m_math.op() != MO_Off)
+    {
+        if (m_mathBlock.size() < size) m_mathBlock.resize(size);
+        m_math.process(block, size, m_mathBlock.data());
+        m_mathView.addBlock(m_mathBlock.data(), size);
+    }
+
+    if (m_maskEnabled) m_mask.block(block, offset, size);
+
+    if (!wasComplete && m_capture.complete())
+    {
+        m_capture.setTiming(m_dsoClock.time(0), m_dsoClock.period());
+        m_sequencer.dsoCapture(m_capture);
+
+        if (m_acquire == AQ_EquivalentTime) _equivalentCaptureDone();
+        if (m_acquire != AQ_Normal) _updateAcquireStats();
+
+        _updateCursorStats();
+        if (m_maskEnabled) _maskCaptureDone();
+
+        if (!m_alarms.empty())
+        {
+            WindowStats st = m_capture.window(0, m_capture.size());
+            double end     = m_dsoClock.time(m_capture.size());
+            m_alarms.feed(AS_DSOMean, end, (float)st.mean);
+            m_alarms.feed(AS_DSORms, end, (float)st.rms);
+        }
+    }
 
-    std::vector<float> v(size);
-    for (uint32_t i = 0; i < size; i++) v[i] = data.data[i] * m_dsoScale;
-    ui->oscilloscope->addBlock(v.data(), size);
+    if (!wasComplete && m_capture.complete() && m_dsoRunning)
+    {
+        // capture complete: space the next one out to save battery
+        uint32_t holdoff = m_battery.dsoHoldoff(m_capture.metadata().window / 1000);
+        if (holdoff)
+        {
+            // a pause, not a stop: a reconnect during it resumes the capture
+            _updateDeviceDSOMode(true, false);
+            m_wheel.start(m_dsoHoldoffTimer, holdoff);
+        }
+    }
 }
 //=============================================================================
 void MainWindow::_dsoMetadata(const DSOMetadata& metadata)
 {
-    m_dsoScale = metadata.scale;
+    PERF_SCOPE(PS_Widget);
+    _setupDSOPage();
+
+    if (m_math.op() != MO_Off && m_capture.size()) m_mathPeak = m_math.peak();
 
-    _setupDSOOscilloscope(metadata);
+    m_capture.reset(metadata);
+    m_dsoClock.begin(m_capture.samplePeriod(), m_mmClock.fit().fitted() ? m_mmClock.fit().slope() : 0.0);
+    m_feed.publish(FR_DSOMetadata, &metadata, sizeof(metadata));
+    m_math.reset(m_capture.samplePeriod());
+    if (m_maskEnabled)
+        m_mask.begin(metadata.samples, rangeFullScale(dsoMode(metadata.mode), metadata.range) / DSO_V_DIVISION_N);
+    if (m_acquire == AQ_Average) m_average.begin(metadata);
 
-    ui->dsoerrorLed->activate(metadata.status == DS_Error);
+    // equivalent time keeps the last reconstruction until the next one
+    if (m_acquire != AQ_EquivalentTime) _setupDSOOscilloscope(metadata);
+    _setupMathOscilloscope();
+
+    // the cursors keep their position across captures, within the window
+    ui->cursorASpin->setMaximum(metadata.window / 1000.0);
+    ui->cursorBSpin->setMaximum(metadata.window / 1000.0);
+
+    if (!_dsoAlarmActive()) ui->dsoerrorLed->activate(metadata.status == DS_Error);
     ui->dsosamplingLed->activate(metadata.status == DS_Sampling);
 
-    ui->dsosamplingrateLabel->setText(QString("%1").arg(metadata.samplingRate));
-    ui->dsosamplesLabel->setText(QString("%1").arg(metadata.samples));
-    ui->dsowindowLabel->setText(QString("%1").arg(metadata.window));
+    m_dsosamplingrateLabel.set(metadata.samplingRate);
+    m_dsosamplesLabel.set(metadata.samples);
+    m_dsowindowLabel.set(metadata.window);
 
-    switch (metadata.mode)
-    {
-        case DOM_Idle:
-            ui->dsomodeLabel->setText("Idle");
-            break;
-        case DOM_VDC:
-            ui->dsomodeLabel->setText("VDC");
-            break;
-        case DOM_VAC:
-            ui->dsomodeLabel->setText("VAC");
-            break;
-        case DOM_ADC:
-            ui->dsomodeLabel->setText("ADC");
-            break;
-        case DOM_AAC:
-            ui->dsomodeLabel->setText("AAC");
-            break;
-    }
+    const ModeDesc& desc = dsoMode(metadata.mode);
+    m_dsomodeLabel.set(desc.shortName);
+    m_dsorangeLabel.set(rangeLabel(desc, metadata.range));
 }
 //=============================================================================
-void MainWindow::centralStateChanged(blew::CentralState newState)
+void MainWindow::_firstSample()
 {
-    if (newState == blew::CS_On) ui->scanButton->setEnabled(true);
+    if (!m_connectClock.isValid()) return;
+
+    m_firstSampleMs = m_connectClock.elapsed();
+    m_connectClock.invalidate();
+
+    statusBar()->showMessage(QString("first sample %1 ms after connect%2")
+                                 .arg(m_firstSampleMs)
+                                 .arg(m_profile.hasMM || m_profile.hasDSO ? " (cached profile)" : ""),
+                             10000);
 }
 //=============================================================================
-void MainWindow::peripheralDiscovered(blew::ble_peripheral peripheral)
+void MainWindow::_decodeDone(std::chrono::steady_clock::time_point t0, bool ok)
 {
-    if (peripheral->name().empty()) return;  // filter all unnamed devices
-    QString uuid(peripheral->uuid().toString().c_str());
-    QString name(peripheral->name().c_str());
-    gui::UltraEntry e(name);
-    e.variant = uuid;
-    ui->connectionSelector->addEntry(e);
+    auto dt     = std::chrono::steady_clock::now() - t0;
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count();
+
+    m_decodeStats.nanos += ns;
+#if PERF_ENABLED == true
+    perfRecord(PS_Decode, ns);
+#endif
+    if (ok)
+        m_decodeStats.accepted++;
+    else
+        m_decodeStats.rejected++;
 }
 //=============================================================================
-void MainWindow::peripheralConnected(blew::ble_peripheral peripheral)
+// most frequent notifications first
+template <typename UUID>
+static PokitChar _charId(const UUID& uuid)
 {
-    m_peripheral = peripheral;
-    ui->connectButton->setText("Disconnect");
-    peripheral->discoverServices();
+    static const PokitChar order[] = {
+        PC_DSOReading, PC_MMReading, PC_DSOMetadata, PC_Status, PC_Button, PC_Torch,
+        PC_Device,     PC_MMSetting, PC_DSOSetting,  PC_FlashLed,
+    };
+
+    for (PokitChar ch : order)
+        if (uuid == pokitCharUuid(ch)) return ch;
+    return PC_Unknown;
 }
 //=============================================================================
-void MainWindow::peripheralDisconnected(blew::ble_peripheral peripheral)
+template <typename UUID>
+static PokitService _serviceId(const UUID& uuid)
 {
-    m_peripheral.reset();
-    ui->connectButton->setText("Connect");
+    for (uint8_t s = PSRV_Status; s < PSRV_Count; s++)
+        if (uuid == pokitServiceUuid((PokitService)s)) return (PokitService)s;
+    return PSRV_Unknown;
 }
 //=============================================================================
-void MainWindow::peripheralUpdatedRSSI(blew::ble_peripheral peripheral) {}
-//=============================================================================
-void MainWindow::servicesDiscovered(blew::ble_peripheral peripheral)
+void MainWindow::centralStateChanged(blew::CentralState newState)
 {
-    // discover all the characteristics (one level deep)
-    peripheral->discoverCharacteristics();
+    if (newState != blew::CS_On) return;
+
+    ui->scanButton->setEnabled(true);
+    if (m_scanReadyMs < 0)
+    {
+        m_scanReadyMs = Application::uptimeMs();
+        _startupReport();
+    }
 }
 //=============================================================================
-void MainWindow::includedServicesDiscovered(blew::ble_service peripheral) {}
-//=============================================================================
-void MainWindow::charsDiscovered(blew::ble_service service)
+void MainWindow::paintEvent(QPaintEvent* event)
 {
-#if DEBUG_FLAG == true
-    fprintf(stderr, "discovered chars for service %s :\n", service->uuid().toString().c_str());
-    for (auto&& el : service->getChars())
+    if (m_firstPaintMs < 0)
     {
-        fprintf(stderr, "    %s\n", el->uuid().toString().c_str());
+        m_firstPaintMs = Application::uptimeMs();
+        _startupReport();
     }
-    fprintf(stderr, "\n");
-#endif
+    QMainWindow::paintEvent(event);
+}
+//=============================================================================
+void MainWindow::_startupReport()
+{
+    if (m_firstPaintMs < 0 || m_scanReadyMs < 0) return;
 
-    auto servid = service->uuid();
-    blew::ble_char c;
+    PRINT("startup: first paint after %lld ms, scan ready after %lld ms", m_firstPaintMs, m_scanReadyMs);
+    statusBar()->showMessage(
+        QString("started in %1 ms, scan ready in %2 ms").arg(m_firstPaintMs).arg(m_scanReadyMs), 5000);
+}
+//=============================================================================
+void MainWindow::peripheralDiscovered(blew::ble_peripheral peripheral) { _scanSeen(peripheral); }
+//=============================================================================
+void MainWindow::peripheralConnected(blew::ble_peripheral peripheral)
+{
+    m_peripheral = peripheral;
+    ui->connectButton->setText("Disconnect");
+
+    // a known device shows its capabilities right away, the device
+    // characteristic read only refreshes them
+    m_peripheralUuid = QString(peripheral->uuid().toString().c_str());
+    if (!m_cache.find(m_peripheralUuid, m_profile)) m_profile = DeviceCache::emptyProfile();
+    m_profile.name = QString(peripheral->name().c_str());
+    if (m_profile.hasData) _updateDevData(m_profile.data);
+
+    m_link.connected();
 
-    if (servid == pokit_status_service)
+    if (m_scanClock.isValid())
     {
-        c = service->getChar(pokit_device_ch);
-        if (c) c->readValue();
+        statusBar()->showMessage(QString("connected %1 ms after scan start").arg(m_scanClock.elapsed()), 10000);
+        m_scanClock.invalidate();
+    }
 
-        c = service->getChar(pokit_status_ch);
-        if (c)
-        {
-            c->subscribe();
-            c->readValue();
-        }
+    peripheral->discoverServices();
+}
+//=============================================================================
+void MainWindow::peripheralDisconnected(blew::ble_peripheral peripheral)
+{
+    _storeProfile();
 
-        c = service->getChar(pokit_button_ch);
-        if (c) c->subscribe();
+    m_peripheral.reset();
+    m_writes.reset();
 
-        c = service->getChar(pokit_torch_ch);
-        if (c) c->subscribe();
-    }
-    else if (servid == pokit_multimeter_service)
+    m_link.disconnected();
+    ui->connectButton->setText(m_link.state() == LS_Lost ? "Cancel" : "Connect");
+}
+//=============================================================================
+void MainWindow::peripheralUpdatedRSSI(blew::ble_peripheral peripheral)
+{
+    if (isScanning()) _scanSeen(peripheral);
+}
+//=============================================================================
+void MainWindow::_scanSeen(blew::ble_peripheral peripheral)
+{
+    if (peripheral->name().empty()) return;  // filter all unnamed devices
+    QString uuid(peripheral->uuid().toString().c_str());
+    QString name(peripheral->name().c_str());
+
+    bool known = m_knownPeripherals.contains(uuid);
+    if (!known && !ScanList::isPokit(name)) return;
+
+    // a new rank rebuilds the picker (coalesced), a new RSSI only rewrites its entry; a
+    // pending rebuild picks the text up anyway
+    int index;
+    ScanChange change = m_scanList.update(uuid, name, (int)peripheral->rssi(), known, &index);
+    if (change != SC_None && !m_wheel.isActive(m_pickerTimer))
     {
-        c = service->getChar(pokit_multimeter_reading_ch);
-        if (c) c->subscribe();
+        if (change == SC_Rank)
+            m_wheel.start(m_pickerTimer, picker_delay_ms);
+        else
+            ui->connectionSelector->setEntryText(index, _pickerText(m_scanList.entries()[index]));
     }
-    else if (servid == pokit_dso_service)
+
+    // a device we already used: no reason to keep scanning
+    if (known && isScanning())
     {
-        c = service->getChar(pokit_dso_metadata_ch);
-        if (c) c->subscribe();
+        _stopScan();
+        _rebuildPicker();
+        _connectTo(uuid);
+    }
+}
+//=============================================================================
+QString MainWindow::_pickerText(const ScanList::Entry& s)
+{
+    return QString("%1  %2 dBm%3").arg(s.name).arg(s.rssi).arg(s.known ? "  *" : "");
+}
+//=============================================================================
+void MainWindow::_rebuildPicker()
+{
+    m_wheel.stop(m_pickerTimer);
 
-        c = service->getChar(pokit_dso_reading_ch);
-        if (c) c->subscribe();
+    // the device the user picked stays picked wherever it moves
+    QString picked;
+    if (ui->connectionSelector->current()) picked = ui->connectionSelector->current()->variant.toString();
+    ui->connectionSelector->clear();
+
+    for (const ScanList::Entry& s : m_scanList.entries())
+    {
+        gui::UltraEntry e(_pickerText(s));
+        e.variant = s.uuid;
+        ui->connectionSelector->addEntry(e, s.uuid == picked);
     }
 }
 //=============================================================================
-void MainWindow::charValueUpdated(blew::ble_char characteristic)
+void MainWindow::servicesDiscovered(blew::ble_peripheral peripheral)
 {
-    auto charuuid    = characteristic->uuid();
-    blew::Buffer buf = characteristic->value();
+    // discover all the characteristics (one level deep)
+    peripheral->discoverCharacteristics();
+}
+//=============================================================================
+void MainWindow::includedServicesDiscovered(blew::ble_service peripheral) {}
+//=============================================================================
+void MainWindow::charsDiscovered(blew::ble_service service)
+{
+    auto servid      = service->uuid();
+    PokitService srv = _serviceId(servid);
+    blew::ble_char c;
+
+    uint8_t ids[32];
+    uint32_t n = 0;
+    for (auto&& el : service->getChars())
+        if (n < sizeof(ids)) ids[n++] = _charId(el->uuid());
 
 #if DEBUG_FLAG == true
-    DEBUG_BUFFER(charuuid, buf);
+    PRINT("discovered chars for service %s :", servid.toString().c_str());
+    for (auto&& el : service->getChars()) PRINT("    %s", el->uuid().toString().c_str());
 #endif
 
-    if (charuuid == pokit_device_ch)
+    switch (srv)
     {
-        DeviceData data = {};
-        buf.copyTo(&data, sizeof(data));
+        case PSRV_Status:
+            c = service->getChar(pokit_device_ch);
+            if (c) c->readValue();
 
-        _updateDevData(data);
-    }
-    else if (charuuid == pokit_status_ch)
-    {
-        DeviceStatus status = {};
-        buf.copyTo(&status, sizeof(status));
+            c = service->getChar(pokit_status_ch);
+            if (c)
+            {
+                c->subscribe();
+                c->readValue();
+            }
 
-        _updateDevStatus(status);
-    }
-    else if (charuuid == pokit_multimeter_reading_ch)
-    {
-        MMReading reading = {};
-        buf.copyTo(&reading, sizeof(reading));
+            c = service->getChar(pokit_button_ch);
+            if (c) c->subscribe();
 
-        ui->mmrangeLabel->setText(_mmrangeToStr(reading.range, reading.mode));
-        ui->mmmodeLabel->setText(_mmmodeToStr(reading.mode));
-        _updateMMLeds(reading.mode, reading.status);
-        ui->mmvalue->setValue(reading.value);
+            c = service->getChar(pokit_torch_ch);
+            if (c) c->subscribe();
+            break;
 
-        m_mmrxTimer.start();
-        ui->mmrxled->activate(true);
-    }
-    else if (charuuid == pokit_button_ch)
-    {
-        DeviceButton b = {};
-        buf.copyTo(&b, sizeof(b));
+        case PSRV_Multimeter:
+            c = service->getChar(pokit_multimeter_reading_ch);
+            if (c) c->subscribe();
+            break;
+
+        case PSRV_DSO:
+            c = service->getChar(pokit_dso_metadata_ch);
+            if (c) c->subscribe();
+
+            c = service->getChar(pokit_dso_reading_ch);
+            if (c) c->subscribe();
+            break;
+
+        default:
+            break;
     }
-    else if (charuuid == pokit_torch_ch)
+
+    _charsReady(srv, ids, n);
+}
+//=============================================================================
+void MainWindow::_charsReady(PokitService srv, const uint8_t* ids, uint32_t n)
+{
+    m_trace.record(TR_Chars, srv, ids, n);
+
+    uint32_t layout = 0;
+    for (uint32_t i = 0; i < n; i++) layout |= 1u << ids[i];
+    m_profile.layout[srv] = layout;
+
+    // resume the last acquisition without waiting for the other services
+    if (srv == PSRV_Multimeter && m_profile.hasMM && m_profile.mm.mode != MM_IDLE)
     {
-        uint8_t byte = 0;
-        buf.copyTo(&byte, 1);
-        ui->torchButton->setState(byte);
+        _showMMSettings(m_profile.mm, m_profile.mmSelected);
+
+        // PRED starts over from its safest range, as when picked
+        if (m_hostAutorange)
+            _updateDeviceMMMode();
+        else
+            _writeMMSettings(m_profile.mm);
     }
-    else if (charuuid == pokit_dso_metadata_ch)
+    if (srv == PSRV_DSO && m_profile.hasDSO && m_profile.dso.mode != DOM_Idle)
     {
-        DSOMetadata d = {};
-        buf.copyTo(&d, sizeof(d));
-        _dsoMetadata(d);
+        _showDSOSettings(m_profile.dso);
+        _writeDSOSettings(m_profile.dso);
     }
-    else if (charuuid == pokit_dso_reading_ch)
+}
+//=============================================================================
+void MainWindow::charValueUpdated(blew::ble_char characteristic)
+{
+    PERF_SCOPE(PS_Receive);
+
+    PokitChar ch     = _charId(characteristic->uuid());
+    blew::Buffer buf = characteristic->value();
+
+    m_trace.value(ch, buf.buffer, buf.size);
+
+    _charValue(ch, buf.buffer, buf.size);
+}
+//=============================================================================
+void MainWindow::_charValue(PokitChar ch, const uint8_t* data, uint32_t size)
+{
+    auto t0  = std::chrono::steady_clock::now();
+    m_rxTime = std::chrono::duration<double>(t0.time_since_epoch()).count();
+    bool ok = true;
+
+    switch (ch)
     {
-        DSOReading r = {};
-        buf.copyTo(&r, sizeof(r));
-        _dsoReading(r, buf.size / 2);
+        case PC_Device:
+        {
+            DeviceData d = {};
+            ok = decodeDeviceData(data, size, d);
+            _decodeDone(t0, ok);
+
+            if (ok)
+            {
+                _updateDevData(d);
+
+                m_profile.data    = d;
+                m_profile.hasData = true;
+                m_profile.mac     = DeviceCache::macToStr(d.macAddr);
+                _profileChanged();
+            }
+            break;
+        }
+        case PC_Status:
+        {
+            DeviceStatus status = {};
+            ok = decodeDeviceStatus(data, size, status);
+            _decodeDone(t0, ok);
+
+            if (ok) _updateDevStatus(status);
+            break;
+        }
+        case PC_MMReading:
+        {
+            MMReading reading = {};
+            ok = decodeMMReading(data, size, reading);
+            _decodeDone(t0, ok);
+
+            if (ok)
+            {
+                PERF_SCOPE(PS_Widget);
+
+                // corrected for the latency and the device clock drift
+                double t = m_mmClock.reading(m_rxTime);
+
+                m_feed.publish(FR_MMReading, &reading, sizeof(reading), t);
+                m_sequencer.mmReading(reading, t);
+
+                const ModeDesc& desc = mmMode(reading.mode);
+                m_mmrangeLabel.set(rangeLabel(desc, reading.range));
+                m_mmmodeLabel.set(desc.name);
+                _updateMMLeds(reading.mode, reading.status);
+                ui->mmvalue->setValue(reading.value);
+
+                if (!m_alarms.empty()) m_alarms.feed(AS_MMValue, t, reading.value);
+
+                // settle latency of whoever does the ranging, host or device;
+                // a fixed range is nobody's, its out of window readings are the user's choice
+                uint8_t selected = _currentMMRange();
+                if (selected == range_auto || selected == range_predictive)
+                    m_rangeSettle[m_hostAutorange].update(reading, t);
+                if (m_hostAutorange && m_autorange.update(reading)) _updateDeviceMMMode();
+
+                if (!m_wheel.isActive(m_mmrxTimer)) ui->mmrxled->activate(true);
+                m_wheel.touch(m_mmrxTimer, rx_timeout_ms);
+
+                _firstSample();
+            }
+            break;
+        }
+        case PC_Button:
+        {
+            DeviceButton b = {};
+            ok = decodeDeviceButton(data, size, b);
+            _decodeDone(t0, ok);
+            break;
+        }
+        case PC_Torch:
+        {
+            uint8_t byte = 0;
+            ok = decodeTorch(data, size, byte);
+            _decodeDone(t0, ok);
+
+            if (ok) ui->torchButton->setState(byte);
+            break;
+        }
+        case PC_DSOMetadata:
+        {
+            DSOMetadata d = {};
+            ok = decodeDSOMetadata(data, size, d);
+            _decodeDone(t0, ok);
+
+            if (ok) _dsoMetadata(d);
+            break;
+        }
+        case PC_DSOReading:
+        {
+            DSOReading r;
+            uint32_t samples = 0;
+            ok = decodeDSOReading(data, size, r, samples);
+            _decodeDone(t0, ok);
 
-        if (sizeof(r) < buf.size)
-            PRINT("DSO reading size mismatch, received %u, expected %lu", buf.size, sizeof(r));
+            if (ok)
+            {
+                _dsoReading(r, samples);
+                _firstSample();
+            }
+            break;
+        }
+        default:
+            break;
     }
+
+    if (!ok)
+        PRINT("rejected malformed packet on ch %s, size %u (%.1f ns/packet validation)", pokitCharName(ch), size,
+              m_decodeStats.nsPerPacket());
 }
 //=============================================================================
 void MainWindow::charValueWritten(blew::ble_char characteristic)
 {
-    if (characteristic->uuid() == pokit_torch_ch)
+    PokitChar ch = _charId(characteristic->uuid());
+    m_writes.written(ch);
+
+    if (ch == PC_Torch)
     {
         auto c = characteristic->value();
 
@@ -894,83 +1240,527 @@ void MainWindow::_onScanButtonClick()
 
     clearBLEPeripherals();
     ui->connectionSelector->clear();
+    m_scanList.clear();
+    m_knownPeripherals = m_cache.knownPeripherals();
 
+    m_scanClock.start();
     startBLEScanning();
 
-    m_scanTimer.setSingleShot(true);
-    m_scanTimer.setInterval(30000);  // 30 seconds
-    m_scanTimer.start();
+    m_wheel.start(m_scanTimer, scan_timeout_ms);
 }
 //=============================================================================
-void MainWindow::_onScanTimerTimeout()
+void MainWindow::_onScanTimerTimeout() { _stopScan(); }
+//=============================================================================
+void MainWindow::_stopScan()
 {
     stopBLEScanning();
+    m_wheel.stop(m_scanTimer);
     ui->scanButton->setState(false);
 }
 //=============================================================================
 void MainWindow::_onMMRxTimerTimeout()
 {
     ui->mmrxled->activate(false);
-    ui->mmmodeLabel->setText(_mmmodeToStr(MM_IDLE));
+    m_mmmodeLabel.set(mmModes[MM_IDLE].name);
 }
 //=============================================================================
 void MainWindow::_onDSORxTimerTimeout() { ui->dsotriggerButton->setState(false); }
 //=============================================================================
-void MainWindow::_deviceSelected(const gui::UltraEntry*)
+void MainWindow::_onDSOHoldoffTimeout()
 {
-    stopBLEScanning();
-    m_scanTimer.stop();
-    ui->scanButton->setState(false);
+    if (m_dsoRunning) _updateDeviceDSOMode();
+}
+//=============================================================================
+void MainWindow::_onTargetRuntimeChange(int hours)
+{
+    m_battery.setTarget(_monoSeconds(), hours * 3600.0);
+    _applyBatterySchedule();
+}
+//=============================================================================
+void MainWindow::_onStatsTimerTimeout()
+{
+    LabelCacheStats now = labelCacheStats;
+
+    m_labelRate.sets          = now.sets - m_lastLabelStats.sets;
+    m_labelRate.skipped       = now.skipped - m_lastLabelStats.skipped;
+    m_labelRate.allocsAvoided = now.allocsAvoided - m_lastLabelStats.allocsAvoided;
+    m_lastLabelStats          = now;
+
+    ScopeViewStats scope = m_scopeView.stats();
+
+    m_scopeRate.blocks          = scope.blocks - m_lastScopeStats.blocks;
+    m_scopeRate.frames          = scope.frames - m_lastScopeStats.frames;
+    m_scopeRate.rescales        = scope.rescales - m_lastScopeStats.rescales;
+    m_scopeRate.rescalesSkipped = scope.rescalesSkipped - m_lastScopeStats.rescalesSkipped;
+    m_lastScopeStats            = scope;
+
+#if DEBUG_FLAG == true
+    PRINT("labels: %llu sets/s, %llu sets/s avoided, %llu allocs/s avoided", (unsigned long long)m_labelRate.sets,
+          (unsigned long long)m_labelRate.skipped, (unsigned long long)m_labelRate.allocsAvoided);
+#endif
+
+    QStringList extra;
+    extra << QString("decode    %1 ns/packet, %2 ok, %3 rejected")
+                 .arg(m_decodeStats.nsPerPacket(), 0, 'f', 1)
+                 .arg(m_decodeStats.accepted)
+                 .arg(m_decodeStats.rejected);
+    if (m_trace.isOpen())
+        extra << QString("trace     %1 records dropped, %2x packed")
+                     .arg(m_trace.dropped())
+                     .arg(m_trace.packRatio(), 0, 'f', 2);
+    if (m_feed.isOpen()) extra << QString("feed      %1 records published").arg(m_feed.published());
+    if (m_automation.isListening())
+        extra << QString("api       %1 clients, %2 steps queued").arg(m_automation.clients()).arg(m_sequencer.pending());
+    if (!m_replayResult.isEmpty()) extra << m_replayResult;
+    if (m_link.outages())
+        extra << QString("link      %1 outages, last %2 ms, max %3 ms")
+                     .arg(m_link.outages())
+                     .arg(m_link.lastOutageMs())
+                     .arg(m_link.maxOutageMs());
+    if (m_firstSampleMs >= 0) extra << QString("connect   first sample after %1 ms").arg(m_firstSampleMs);
+    if (m_mmClock.fit().points() || m_dsoClock.fit().points())
+        extra << QString("clock     mm %1 ppm, jitter %2 ms (%3 s fitted), dso %4 ppm, jitter %5 ms")
+                     .arg(m_mmClock.fit().ppm(), 0, 'f', 1)
+                     .arg(m_mmClock.fit().jitter() * 1000.0, 0, 'f', 2)
+                     .arg(m_mmClock.fit().points())
+                     .arg(m_dsoClock.fit().ppm(), 0, 'f', 1)
+                     .arg(m_dsoClock.fit().jitter() * 1000.0, 0, 'f', 2);
+    extra << QString("startup   first paint %1 ms, scan ready %2 ms, dso page %3")
+                 .arg(m_firstPaintMs)
+                 .arg(m_scanReadyMs)
+                 .arg(m_dsoPageMs < 0.0 ? QString("not built") : QString("built in %1 ms").arg(m_dsoPageMs, 0, 'f', 1));
+    extra << QString("labels    %1 set/s, %2 avoided/s, %3 allocs avoided/s")
+                 .arg(m_labelRate.sets)
+                 .arg(m_labelRate.skipped)
+                 .arg(m_labelRate.allocsAvoided);
+    extra << QString("scope     %1 blocks/s in %2 frames/s, %3 rescales/s, %4 avoided/s")
+                 .arg(m_scopeRate.blocks)
+                 .arg(m_scopeRate.frames)
+                 .arg(m_scopeRate.rescales)
+                 .arg(m_scopeRate.rescalesSkipped);
+
+    extra << QString("autorange device settle %1 ms mean (%2), host %3 ms mean (%4, %5 switches)")
+                 .arg(m_rangeSettle[0].meanMs(), 0, 'f', 1)
+                 .arg(m_rangeSettle[0].count())
+                 .arg(m_rangeSettle[1].meanMs(), 0, 'f', 1)
+                 .arg(m_rangeSettle[1].count())
+                 .arg(m_autorange.switches());
+    extra << QString("writes    %1 issued, %2 coalesced, %3 timeouts, settle last %4 ms max %5 ms")
+                 .arg(m_writes.issued())
+                 .arg(m_writes.coalesced())
+                 .arg(m_writes.timeouts())
+                 .arg(m_writes.lastSettleMs(), 0, 'f', 1)
+                 .arg(m_writes.maxSettleMs(), 0, 'f', 1);
+    if (!m_alarms.empty())
+        extra << QString("alarms    %1 rules, %2 raised since start").arg(m_alarms.ruleCount()).arg(m_alarms.raisedTotal());
+    m_perfOverlay->refresh(stats_interval_ms / 1000.0, extra);
 }
 //=============================================================================
+void MainWindow::replayValue(PokitChar ch, const uint8_t* data, uint32_t size)
+{
+    PERF_SCOPE(PS_Receive);
+
+    m_trace.value(ch, data, size);
+    _charValue(ch, data, size);
+}
+//=============================================================================
+void MainWindow::replayChars(PokitService service, const uint8_t* ids, uint32_t n)
+{
+    _charsReady(service, ids, n);
+}
+//=============================================================================
+void MainWindow::replayFinished(uint64_t events, double seconds)
+{
+    m_replayResult = QString("replay    %1 events in %2 s, %3 ev/s")
+                         .arg(events)
+                         .arg(seconds, 0, 'f', 3)
+                         .arg(seconds > 0.0 ? events / seconds : 0.0, 0, 'f', 0);
+    PRINT("%s", m_replayResult.toUtf8().constData());
+}
+//=============================================================================
+void MainWindow::_onPerfOverlayToggle() { m_perfOverlay->toggle(); }
+//=============================================================================
+void MainWindow::_onReconnectAttempt(const QString& uuid)
+{
+    m_connectClock.start();
+    connectBLEPeripheral(uuid.toStdString());
+}
+//=============================================================================
+void MainWindow::_onLinkLost()
+{
+    PRINT("link lost, reconnecting");
+    statusBar()->showMessage("link lost, reconnecting...");
+}
+//=============================================================================
+void MainWindow::_onLinkRestored(qint64 outageMs)
+{
+    // the gap record is stamped at the end of the outage and carries its length
+    uint64_t ns = uint64_t(outageMs) * 1000000u;
+    m_trace.record(TR_Gap, 0, &ns, sizeof(ns));
+
+    PRINT("link restored after %lld ms", (long long)outageMs);
+    statusBar()->showMessage(QString("link restored after %1 ms").arg(outageMs), 10000);
+}
+//=============================================================================
+void MainWindow::_deviceSelected(const gui::UltraEntry*) { _stopScan(); }
+//=============================================================================
 void MainWindow::_onConnectButtonClick()
 {
     if (m_peripheral)  // already connected
+    {
+        m_link.disconnectRequested();
         m_peripheral->disconnect();
+    }
+    else if (m_link.state() == LS_Lost)  // give up reconnecting
+    {
+        m_link.disconnectRequested();
+        ui->connectButton->setText("Connect");
+        statusBar()->clearMessage();
+    }
     else if (ui->connectionSelector->current())
-        connectBLEPeripheral(ui->connectionSelector->current()->variant.toString().toStdString());
+        _connectTo(ui->connectionSelector->current()->variant.toString());
+}
+//=============================================================================
+void MainWindow::_connectTo(const QString& uuid)
+{
+    if (m_peripheral) return;
+
+    m_connectClock.start();
+    m_link.connectRequested(uuid);
+    connectBLEPeripheral(uuid.toStdString());
 }
 //=============================================================================
 void MainWindow::_onDeviceModeChange(int32_t id, void* p)
 {
-    // noop
+    if (id != GDM_Oscilloscope) return;
+
+    // the page shows up with the latest trace, not the one of the previous frame
+    _setupDSOPage();
+    m_scopeView.flush();
+    m_mathView.flush();
+}
+//=============================================================================
+// oscilloscope page selectors, math, mask and acquisition controls, built the
+// first time the page is selected or DSO data shows up
+void MainWindow::_setupDSOPage()
+{
+    if (m_dsoPageMs >= 0.0) return;
+    QElapsedTimer clock;
+    clock.start();
+
+    ui->dsoRangeSelector->setArrayDir(gui::AD_Vertical);
+
+    ui->dsotriggerButton->setAutoMode(false);
+    ui->dsotriggerButton->setActiveText("RUNNING");
+
+    _fillDSOSelectors(DSOC_FallingEdge, DOM_VDC);
+
+    //
+
+    for (uint8_t op = MO_Off; op < MO_Count; op++) ui->mathOpCombo->addItem(mathOpName((MathOp)op));
+    m_math.setWindow(ui->mathWindowSpin->value());
+    m_math.setExpression(ui->mathExprEdit->text().toStdString());
+    _setupMathOscilloscope();
+
+    for (uint8_t m = AQ_Normal; m < AQ_Count; m++) ui->acqModeCombo->addItem(acquireModeName((AcquireMode)m));
+
+    _setupDSORangeSelector(DOM_VDC);
+
+    // clang-format off
+    connect(ui->dsoModeSelector, SIGNAL(onClick(int32_t,void*)), this,
+            SLOT(_onDSOModeChange(int32_t,void*)));
+
+    connect(ui->dsoMeasureSelector, SIGNAL(onClick(int32_t,void*)), this,
+            SLOT(_onDSOMeasureChange(int32_t,void*)));
+
+    connect(ui->dsoRangeSelector, SIGNAL(onClick(const gui::UltraEntry*)), this,
+            SLOT(_onDSORangeSelectorPress(const gui::UltraEntry*)));
+
+    connect(ui->mathOpCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(_onMathOpChange(int)));
+    connect(ui->mathExprEdit, SIGNAL(editingFinished()), this, SLOT(_onMathExprChange()));
+    connect(ui->mathWindowSpin, SIGNAL(valueChanged(int)), this, SLOT(_onMathWindowChange(int)));
+    connect(ui->storeRefButton, SIGNAL(clicked()), this, SLOT(_onStoreReference()));
+    connect(ui->clearRefButton, SIGNAL(clicked()), this, SLOT(_onClearReference()));
+    connect(ui->cursorASpin, SIGNAL(valueChanged(double)), this, SLOT(_onCursorChange()));
+    connect(ui->cursorBSpin, SIGNAL(valueChanged(double)), this, SLOT(_onCursorChange()));
+    connect(ui->maskEnableCheck, SIGNAL(toggled(bool)), this, SLOT(_onMaskEnableChange(bool)));
+    connect(ui->maskFromRefButton, SIGNAL(clicked()), this, SLOT(_onMaskFromReference()));
+    connect(ui->acqModeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(_onAcquireModeChange(int)));
+    connect(ui->acqCountSpin, SIGNAL(valueChanged(int)), this, SLOT(_onAcquireCountChange(int)));
+
+    connect(ui->dsotriggerButton, SIGNAL(onChange(bool)), this, SLOT(_onDsoTriggerButtonChange(bool)));
+    // clang-format on
+
+    m_dsoPageMs = clock.nsecsElapsed() / 1e6;
 }
 //=============================================================================
 void MainWindow::_onMultimeterModeChange(int32_t id, void* p)
 {
     if (id < 0) return;
     _setupMMRangeSelector((MultimeterMode)id);
+
+    for (RangeSettleMeter& m : m_rangeSettle) m.reset();
+    _restartAutoRange();
+    _updateDeviceMMMode();
+}
+//=============================================================================
+void MainWindow::_onMultimeterRangeSelectorPress(const gui::UltraEntry* entry)
+{
+    // a settle in progress is not the ranging's doing once the user picks a range
+    for (RangeSettleMeter& m : m_rangeSettle) m.interrupt();
+    _restartAutoRange();
     _updateDeviceMMMode();
 }
 //=============================================================================
-void MainWindow::_onMultimeterRangeSelectorPress(const gui::UltraEntry* entry) { _updateDeviceMMMode(); }
+void MainWindow::_restartAutoRange()
+{
+    m_hostAutorange = _currentMMRange() == range_predictive;
+    if (m_hostAutorange) m_autorange.setMode(_currentMMMode());
+}
 //=============================================================================
 void MainWindow::_onDSOModeChange(int32_t id, void* p) { _updateDeviceDSOMode(); }
 //=============================================================================
 void MainWindow::_onDSORangeSelectorPress(const gui::UltraEntry*) { _updateDeviceDSOMode(); }
 //=============================================================================
-void MainWindow::_onDSOMeasureChange(int32_t id, void* p) { _updateDeviceDSOMode(); }
+void MainWindow::_onDSOMeasureChange(int32_t id, void* p)
+{
+    if (id >= 0) _setupDSORangeSelector((DSOOpMode)id);
+    _updateDeviceDSOMode();
+}
 //=============================================================================
-void MainWindow::_onTorchButtonChange(bool newstate)
+void MainWindow::_onMathOpChange(int index)
 {
-    if (!m_peripheral) return;
+    MathOp op = (MathOp)index;
+    m_math.setOp(op);
 
-    blew::ble_char c = m_peripheral->characteristic_r(pokit_torch_ch);
-    if (!c) return;
+    ui->mathExprEdit->setEnabled(op == MO_Expression);
+    ui->mathWindowSpin->setEnabled(op == MO_MovingAverage);
 
-    uint8_t x = newstate ? 1 : 0;
-    blew::Buffer b(&x, 1);
+    _rebuildMath();
+}
+//=============================================================================
+void MainWindow::_onMathExprChange()
+{
+    std::string error;
+    if (!m_math.setExpression(ui->mathExprEdit->text().toStdString(), &error))
+    {
+        statusBar()->showMessage(QString("math expression: %1").arg(error.c_str()), 5000);
+        return;
+    }
 
-    MMSettings mmsettings = {};
+    if (m_math.op() == MO_Expression) _rebuildMath();
+}
+//=============================================================================
+void MainWindow::_onMathWindowChange(int samples)
+{
+    m_math.setWindow(samples);
+    if (m_math.op() == MO_MovingAverage) _rebuildMath();
+}
+//=============================================================================
+void MainWindow::_onStoreReference()
+{
+    if (!m_capture.size()) return;
+
+    m_math.setReference(m_capture.data(), m_capture.size());
+    statusBar()->showMessage(QString("reference stored: %1 %2, %3 samples")
+                                 .arg(dsoMode(m_capture.metadata().mode).shortName)
+                                 .arg(rangeLabel(dsoMode(m_capture.metadata().mode), m_capture.metadata().range))
+                                 .arg(m_capture.size()),
+                             5000);
+    _rebuildMath();
+}
+//=============================================================================
+void MainWindow::_onClearReference()
+{
+    m_math.clearReference();
+    _rebuildMath();
+}
+//=============================================================================
+bool MainWindow::_dsoAlarmActive() const { return m_alarms.active(AS_DSOMean) || m_alarms.active(AS_DSORms); }
+//=============================================================================
+void MainWindow::_onAlarm(const AlarmEvent& e)
+{
+    const AlarmRule& rule = m_alarms.rule(e.rule);
+
+    // tag the recorded stream: rule index in `ch`, TraceAlarm + rule text
+    uint8_t buf[sizeof(TraceAlarm) + 128];
+    TraceAlarm a  = {e.raised, e.value};
+    uint32_t text = std::min<uint32_t>((uint32_t)rule.text.size(), sizeof(buf) - sizeof(a));
+    memcpy(buf, &a, sizeof(a));
+    memcpy(buf + sizeof(a), rule.text.data(), text);
+    m_trace.record(TR_Alarm, (uint8_t)e.rule, buf, sizeof(a) + text);
+
+    PRINT("alarm %s: %s (%g)", e.raised ? "raised" : "cleared", rule.text.c_str(), e.value);
+
+    if (e.raised)
+    {
+        statusBar()->showMessage(QString("ALARM: %1 (%2)").arg(rule.text.c_str()).arg(e.value), 10000);
+        if (!m_wheel.isActive(m_alarmBlinkTimer)) m_wheel.start(m_alarmBlinkTimer, alarm_blink_ms, true);
+    }
+}
+//=============================================================================
+void MainWindow::_onAlarmBlink()
+{
+    bool mm  = m_alarms.active(AS_MMValue);
+    bool dso = _dsoAlarmActive();
+
+    m_alarmBlink = (mm || dso) && !m_alarmBlink;
+    if (!mm && !dso) m_wheel.stop(m_alarmBlinkTimer);
+
+    // the next reading / metadata restores the device error state
+    ui->mmerrorLed->activate(mm && m_alarmBlink);
+    ui->dsoerrorLed->activate(dso && m_alarmBlink);
+}
+//=============================================================================
+void MainWindow::_maskCaptureDone()
+{
+    if (m_mask.end())
+    {
+        _updateMaskStats();
+        return;
+    }
+
+    // the failing trace is on screen when the failure is reported
+    m_scopeView.flush();
+
+    QDir().mkpath(m_maskFailDir);
+    QString path = QString("%1/fail_%2_%3.csv")
+                       .arg(m_maskFailDir)
+                       .arg(m_mask.failed(), 6, 10, QChar('0'))
+                       .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz"));
+
+    // the mask tested the averaged trace, that is what failed
+    bool average = m_acquire == AQ_Average;
+    bool saved   = average ? m_capture.save(path.toStdString(), m_average.data(), m_average.size())
+                           : m_capture.save(path.toStdString());
+    PRINT("mask: %s failed, %u samples out of mask, %s %s", average ? "averaged trace" : "capture",
+          m_mask.violations(), saved ? "saved to" : "can't save", path.toUtf8().constData());
+
+    _updateMaskStats();
+}
+//=============================================================================
+void MainWindow::_updateMaskStats()
+{
+    if (!m_mask.isValid())
+    {
+        ui->maskStatsLabel->setText("no mask");
+        return;
+    }
+
+    uint64_t tested = m_mask.tested();
+    ui->maskStatsLabel->setText(QString("%1 tested, %2 failed (%3%)")
+                                    .arg(tested)
+                                    .arg(m_mask.failed())
+                                    .arg(tested ? 100.0 * m_mask.failed() / tested : 0.0, 0, 'f', 2));
+}
+//=============================================================================
+void MainWindow::_onMaskEnableChange(bool enabled)
+{
+    if (enabled && !m_mask.isValid())
+    {
+        statusBar()->showMessage("mask: no mask loaded, set GOKIT_MASK or build it from the reference", 5000);
+        ui->maskEnableCheck->setChecked(false);
+        return;
+    }
+
+    m_maskEnabled = enabled;
+    m_mask.resetCounters();
+    _updateMaskStats();
+    if (!enabled) return;
+
+    // catch up with the part of the capture already received
+    const DSOMetadata& metadata = m_capture.metadata();
+    m_mask.begin(metadata.samples, rangeFullScale(dsoMode(metadata.mode), metadata.range) / DSO_V_DIVISION_N);
+    m_mask.block(m_capture.data(), 0, m_capture.size());
+}
+//=============================================================================
+void MainWindow::_onMaskFromReference()
+{
+    const std::vector<float>& ref = m_math.reference();
+    if (ref.empty())
+    {
+        statusBar()->showMessage("mask: store a reference first", 5000);
+        return;
+    }
 
-    c->writeValue(b);
+    const DSOMetadata& metadata = m_capture.metadata();
+    float tolerance = rangeFullScale(dsoMode(metadata.mode), metadata.range) * ui->maskTolSpin->value() / 100.0f;
+    m_mask.fromReference(ref.data(), (uint32_t)ref.size(), tolerance);
+
+    _onMaskEnableChange(m_maskEnabled);
+}
+//=============================================================================
+void MainWindow::_onCursorChange() { _updateCursorStats(); }
+//=============================================================================
+void MainWindow::_onTorchButtonChange(bool newstate)
+{
+    uint8_t x = newstate ? 1 : 0;
+    m_writes.write(PC_Torch, &x, 1);
 }
 //=============================================================================
 void MainWindow::_onDsoTriggerButtonChange(bool state)
 {
+    m_dsoRunning = state;
+    m_wheel.stop(m_dsoHoldoffTimer);
+
     if (state)
         _updateDeviceDSOMode();
     else
         _updateDeviceDSOMode(true);
 }
 //=============================================================================
+void MainWindow::_equivalentCaptureDone()
+{
+    const DSOMetadata& metadata = m_capture.metadata();
+    if (!m_equivalent.add(metadata, m_capture.data(), m_capture.size())) return;  // no edge to align on
+
+    _setupDSOOscilloscope(metadata, m_equivalent.factor());
+    m_scopeView.addBlock(m_equivalent.data(), m_equivalent.size());
+}
+//=============================================================================
+void MainWindow::_updateAcquireStats()
+{
+    switch (m_acquire)
+    {
+        case AQ_Average:
+            ui->acqStatsLabel->setText(QString("%1 / %2 captures").arg(m_average.averaged()).arg(m_average.count()));
+            break;
+        case AQ_EquivalentTime:
+        {
+            uint32_t bins = m_equivalent.size();
+            float rate    = m_capture.metadata().samplingRate * (float)m_equivalent.factor();
+            ui->acqStatsLabel->setText(QString("%1 captures, %2% filled, %3 kS/s equivalent")
+                                           .arg(m_equivalent.captures())
+                                           .arg(bins ? 100.0 * m_equivalent.filled() / bins : 0.0, 0, 'f', 0)
+                                           .arg(rate / 1000.0f, 0, 'f', 0));
+            break;
+        }
+        default:
+            ui->acqStatsLabel->clear();
+            break;
+    }
+}
+//=============================================================================
+void MainWindow::_onAcquireModeChange(int index)
+{
+    m_acquire = (AcquireMode)index;
+    ui->acqCountSpin->setEnabled(m_acquire != AQ_Normal);
+    _onAcquireCountChange(ui->acqCountSpin->value());
+    if (m_acquire == AQ_Average) m_average.begin(m_capture.metadata());
+
+    // back to the raw trace right away, the others build up from the next capture
+    if (m_acquire == AQ_Normal && m_capture.size())
+    {
+        _setupDSOOscilloscope(m_capture.metadata());
+        std::vector<float> raw(m_capture.data(), m_capture.data() + m_capture.size());
+        m_scopeView.addBlock(raw.data(), (uint32_t)raw.size());
+    }
+}
+//=============================================================================
+void MainWindow::_onAcquireCountChange(int count)
+{
+    m_average.setCount(count);
+    m_equivalent.setFactor(count);
+    _updateAcquireStats();
+}
+//=============================================================================
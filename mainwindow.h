@@ -4,8 +4,36 @@
 #include <blewrapper/central.h>
 #include <ultragui/types.h>
 
+#include "acquisition.h"
+#include "alarms.h"
+#include "automation.h"
+#include "autorange.h"
+#include "batteryscheduler.h"
+#include "capture.h"
+#include "devicecache.h"
+#include "labelcache.h"
+#include "linksupervisor.h"
+#include "livefeed.h"
+#include "masktest.h"
+#include "mathchannel.h"
+#include "perfoverlay.h"
+#include "protocol.h"
+#include "sampleclock.h"
+#include "scanlist.h"
+#include "scopeview.h"
+#include "sequencer.h"
+#include "timerwheel.h"
+#include "tracelog.h"
+#include "tracereplay.h"
+#include "writequeue.h"
+
+#include <QElapsedTimer>
 #include <QMainWindow>
-#include <QTimer>
+
+#include <array>
+#include <chrono>
+#include <utility>
+#include <vector>
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -14,178 +42,105 @@ namespace Ui
 }
 QT_END_NAMESPACE
 
-enum DeviceState : uint8_t
+class MainWindow : public QMainWindow, private blew::Central, private TraceSink
 {
-    DS_MM_Idle        = 0,
-    DS_MM_DCVoltage   = 1,
-    DS_MM_ACVoltage   = 2,
-    DS_MM_DCCUrrent   = 3,
-    DS_MM_ACCurrent   = 4,
-    DS_MM_Resistance  = 5,
-    DS_MM_Diode       = 6,
-    DS_MM_Continuity  = 7,
-    DS_MM_Temperature = 8,
-    DS_DSO            = 9,
-    DS_Datalogger     = 10,
-};
+    Q_OBJECT
 
-enum MultimeterMode : uint8_t
-{
-    MM_IDLE        = 0,
-    MM_DCVoltage   = 1,
-    MM_ACVoltage   = 2,
-    MM_DCCurrent   = 3,
-    MM_ACCurrent   = 4,
-    MM_Resistance  = 5,
-    MM_Diode       = 6,
-    MM_Continuity  = 7,
-    MM_Temperature = 8,
-};
+   public:
+    MainWindow(QWidget* parent = nullptr);
+    virtual ~MainWindow();
 
-enum ModeSwitchPosition : uint8_t
-{
-    MSP_Voltage = 0,
-    MSP_Mixed   = 1,
-    MSP_Current = 2,
-};
+   private:
+    Ui::MainWindow* ui;
+    blew::ble_peripheral m_peripheral;
 
-enum ButtonAction : uint8_t
-{
-    BA_Release   = 0,
-    BA_Pressed   = 1,
-    BA_LongPress = 2,
-};
+    // every timeout of the window lives on one coarse wheel, these are its ids
+    TimerWheel m_wheel;
+    int m_scanTimer, m_mmrxTimer, m_dsorxTimer, m_statsTimer, m_pickerTimer, m_dsoHoldoffTimer, m_alarmBlinkTimer,
+        m_profileTimer;
 
-enum DSOCommand : uint8_t
-{
-    DSOC_FreeRunning = 0,
-    DSOC_RisingEdge  = 1,
-    DSOC_FallingEdge = 2,
-    DSOC_Resend      = 3,
-    DSOC_Spare0      = 4,  // unknown
-    DSOC_Continuos   = 5,  // undocumented
-};
+    enum GUIDevMode
+    {
+        GDM_Multimeter,
+        GDM_Oscilloscope,
+        GDM_Datalogger,
+    };
 
-enum DSOOpMode : uint8_t
-{
-    DOM_Idle = 0,
-    DOM_VDC  = 1,
-    DOM_VAC  = 2,
-    DOM_ADC  = 3,
-    DOM_AAC  = 4,
-};
+    DSOCommand m_dsoCmd;
 
-enum DSOStatus : uint8_t
-{
-    DS_Done     = 0,
-    DS_Sampling = 1,
-    DS_Error    = 255,
-};
+    bool m_dsoRunning;
+    CaptureBuffer m_capture;  // DSO acquisition in progress
 
-#pragma pack(push, 1)
-struct DeviceData
-{
-    uint8_t fwMaj;
-    uint8_t fwMin;
-    uint16_t maxVoltage;       // In V
-    uint16_t maxCurrent;       // In A
-    uint16_t maxResistance;    // In KOhm
-    uint16_t maxSamplingRate;  // in KHz
-    uint16_t maxBufferSize;
-    uint16_t reserved;
-    uint8_t macAddr[6];
-};
+    double m_rxTime;  // host receipt of the notification being handled, steady clock seconds
+    ReadingClock m_mmClock;
+    CaptureClock m_dsoClock;
 
-struct DeviceStatus
-{
-    DeviceState state;
-    float batteryVoltage;  //[0 - 3.3v]
+    MathChannel m_math;
+    std::vector<float> m_mathBlock;
+    float m_mathPeak;  // of the previous capture, sets the math vertical scale
 
-    // undocumented
-    uint8_t spare0;
-    ModeSwitchPosition modeswitch;
-    uint8_t spare1;
-};
+    AlarmEngine m_alarms;  // rules from GOKIT_ALARMS
+    bool m_alarmBlink;
 
-struct MMSettings
-{
-    MultimeterMode mode;
-    uint8_t range;
-    uint32_t updateInterval;
-};
+    MaskTest m_mask;
+    bool m_maskEnabled;
+    QString m_maskFailDir;  // where the failing captures go
 
-struct MMReading
-{
-    uint8_t status;
-    float value;
-    MultimeterMode mode;
-    uint8_t range;
-};
+    AutoRange m_autorange;
+    bool m_hostAutorange;               // "PRED" range selected
+    RangeSettleMeter m_rangeSettle[2];  // device autorange, host autorange
 
-struct DeviceButton
-{
-    uint8_t spare;
-    ButtonAction button;
-};
+    AcquireMode m_acquire;
+    CaptureAverage m_average;
+    EquivalentTime m_equivalent;
 
-struct DSOSettings
-{
-    DSOCommand command;
-    float trigger;
-    DSOOpMode mode;
-    uint8_t range;
-    uint32_t window;
-    uint16_t samples;  // 1~8192
-};
+    DecodeStats m_decodeStats;
+    TraceLog m_trace;
+    LiveFeed m_feed;
 
-struct DSOMetadata
-{
-    DSOStatus status;
-    float scale;
-    DSOOpMode mode;
-    uint8_t range;
-    uint32_t window;
-    uint16_t samples;
-    uint32_t samplingRate;
-
-    // undocumented and unknown data:
-    uint8_t spare0;
-    uint8_t spare1;
-    uint8_t spare2;
-    uint8_t spare3;
-    uint8_t spare4;
-};
+    // per second rates, refreshed by m_statsTimer
+    LabelCacheStats m_lastLabelStats, m_labelRate;
 
-struct DSOReading
-{
-    int16_t data[88];  // doc says 10 -_-
-};
+    CachedLabel<uint16_t> m_fwLabel, m_maxVoltLabel, m_maxCurrentLabel, m_maxResistanceLabel,
+        m_maxSampleRateLabel, m_bufSizeLabel;
+    CachedLabel<std::array<uint8_t, 6>> m_macAddrLabel;
+    CachedLabel<const char*> m_statusLabel;
+    CachedLabel<float> m_batteryLabel;
+    CachedLabel<const char*> m_modeSwitchLabel, m_mmrangeLabel, m_mmmodeLabel;
+    CachedLabel<uint32_t> m_dsosamplingrateLabel, m_dsosamplesLabel, m_dsowindowLabel;
+    CachedLabel<const char*> m_dsomodeLabel, m_dsorangeLabel;
+    CachedLabel<std::pair<int32_t, int32_t>> m_runtimeLabel;
 
-#pragma pack(pop)
+    uint8_t m_lastModeSwitch;
 
-class MainWindow : public QMainWindow, private blew::Central
-{
-    Q_OBJECT
+    PerfOverlay* m_perfOverlay;  // toggled with F12
 
-   public:
-    MainWindow(QWidget* parent = nullptr);
-    virtual ~MainWindow();
+    TraceReplay* m_replay;  // only when GOKIT_REPLAY is set
+    QString m_replayResult;
 
-   private:
-    Ui::MainWindow* ui;
-    blew::ble_peripheral m_peripheral;
-    QTimer m_scanTimer, m_mmrxTimer, m_dsorxTimer;
+    DeviceCache m_cache;
+    DeviceProfile m_profile;  // of the connected device, stored by m_profileTimer or on disconnect
+    QString m_peripheralUuid;
+    QElapsedTimer m_connectClock;  // valid from the connect request to the first sample
+    qint64 m_firstSampleMs;
+    qint64 m_firstPaintMs, m_scanReadyMs;  // since the process start
+    double m_dsoPageMs;                    // build time of the DSO page, < 0 until first used
 
-    enum GUIDevMode
-    {
-        GDM_Multimeter,
-        GDM_Oscilloscope,
-        GDM_Datalogger,
-    };
+    LinkSupervisor m_link;
+    WriteQueue m_writes;  // settings and torch writes
 
-    float m_dsoScale;
+    Sequencer m_sequencer;  // measurement plans of the automation clients
+    AutomationServer m_automation;
 
-    DSOCommand m_dsoCmd;
+    ScanList m_scanList;
+    QSet<QString> m_knownPeripherals;  // snapshot taken when the scan starts
+    QElapsedTimer m_scanClock;
+
+    BatteryScheduler m_battery;
+    float m_appliedSlowdown;
+
+    ScopeView m_scopeView, m_mathView;  // oscilloscope and mathOscilloscope
+    ScopeViewStats m_lastScopeStats, m_scopeRate;
 
     MultimeterMode _currentMMMode();
     uint8_t _currentMMRange();
@@ -193,29 +148,64 @@ class MainWindow : public QMainWindow, private blew::Central
     DSOCommand _currentDSOCommand();
     DSOOpMode _currentDSOMode();
 
-    QString _modeswToStr(ModeSwitchPosition mode);
+    static const char* _modeswToStr(ModeSwitchPosition mode);
+    static const char* _devstateToStr(DeviceState state);
+    static QString _textToStr(const char* const& text);
+    static QString _macToStr(const std::array<uint8_t, 6>& mac);
+    static QString _runtimeToStr(const std::pair<int32_t, int32_t>& r);
+    static QString _pickerText(const ScanList::Entry& s);
 
     void _updateDevData(const DeviceData& data);
     void _updateDevStatus(const DeviceStatus& status);
 
+    void _applyBatterySchedule();
     void _updateDeviceMMMode();
-    void _updateDeviceDSOMode(bool stop = false);
-
+    void _restartAutoRange();
+    void _updateDeviceDSOMode(bool stop = false, bool remember = true);
+    void _writeMMSettings(const MMSettings& settings);
+    void _writeDSOSettings(const DSOSettings& settings, bool remember = true);
+    void _profileChanged();
+    void _storeProfile();
+
+    void _showMMSettings(const MMSettings& settings, uint8_t selected);
+    void _showDSOSettings(const DSOSettings& settings);
+    void _fillMMModeSelector(int current = -1);
+    void _fillDSOSelectors(DSOCommand command, DSOOpMode mode);
     void _setupMMModeSelector(ModeSwitchPosition sw);
-    void _setupMMRangeSelector(MultimeterMode mode);
-    void _setupDSORangeSelector(DSOOpMode mode);
-    void _setupDSOOscilloscope(const DSOMetadata& metadata);
-
-    static QString _mmrangeToStr(uint8_t range, MultimeterMode mode);
-    static QString _mmmodeToStr(MultimeterMode mode);
-    static float _dsorangeToMax(DSOOpMode mode, uint8_t range);
-    static QString _dsorangeToStr(DSOOpMode mode, uint8_t range);
+    void _setupMMRangeSelector(MultimeterMode mode, int current = -1);
+    void _setupDSORangeSelector(DSOOpMode mode, uint8_t current = 0);
+    void _setupDSOOscilloscope(const DSOMetadata& metadata, uint32_t interleave = 1);
+    void _setupMathOscilloscope();
+    void _setupDSOPage();
+    void _rebuildMath();
+    void _updateCursorStats();
+
+    bool _dsoAlarmActive() const;
+    void _onAlarm(const AlarmEvent& e);
+    void _onAlarmBlink();
+
+    void _maskCaptureDone();
+    void _updateMaskStats();
+    void _equivalentCaptureDone();
+    void _updateAcquireStats();
 
     void _updateMMLeds(MultimeterMode mode, uint8_t status);
 
     void _dsoReading(const DSOReading& data, uint32_t size);
     void _dsoMetadata(const DSOMetadata& metadata);
 
+    void _charsReady(PokitService srv, const uint8_t* ids, uint32_t n);
+    void _charValue(PokitChar ch, const uint8_t* data, uint32_t size);
+    void _firstSample();
+
+    void _scanSeen(blew::ble_peripheral peripheral);
+    void _stopScan();
+    void _connectTo(const QString& uuid);
+    void _decodeDone(std::chrono::steady_clock::time_point t0, bool ok);
+    void _startupReport();
+
+    virtual void paintEvent(QPaintEvent* event) override;
+
     virtual void centralStateChanged(blew::CentralState newState) override;
     virtual void peripheralDiscovered(blew::ble_peripheral peripheral) override;
     virtual void peripheralConnected(blew::ble_peripheral peripheral) override;
@@ -230,13 +220,25 @@ class MainWindow : public QMainWindow, private blew::Central
     virtual void charValueWritten(blew::ble_char characteristic) override;
     virtual void charUpdatedSubscribeStatus(blew::ble_char characteristic, bool ok) override;
 
+    virtual void replayValue(PokitChar ch, const uint8_t* data, uint32_t size) override;
+    virtual void replayChars(PokitService service, const uint8_t* ids, uint32_t n) override;
+    virtual void replayFinished(uint64_t events, double seconds) override;
+
    private slots:
     void _onScanButtonClick();
     void _onScanTimerTimeout();
     void _onMMRxTimerTimeout();
     void _onDSORxTimerTimeout();
+    void _onDSOHoldoffTimeout();
+    void _onTargetRuntimeChange(int hours);
+    void _onStatsTimerTimeout();
+    void _onPerfOverlayToggle();
     void _deviceSelected(const gui::UltraEntry*);
     void _onConnectButtonClick();
+    void _rebuildPicker();
+    void _onReconnectAttempt(const QString& uuid);
+    void _onLinkLost();
+    void _onLinkRestored(qint64 outageMs);
 
     void _onDeviceModeChange(int32_t id, void* p);
 
@@ -247,6 +249,17 @@ class MainWindow : public QMainWindow, private blew::Central
     void _onDSORangeSelectorPress(const gui::UltraEntry*);
     void _onDSOMeasureChange(int32_t id, void* p);
 
+    void _onMathOpChange(int index);
+    void _onMathExprChange();
+    void _onMathWindowChange(int samples);
+    void _onStoreReference();
+    void _onClearReference();
+    void _onCursorChange();
+    void _onMaskEnableChange(bool enabled);
+    void _onMaskFromReference();
+    void _onAcquireModeChange(int index);
+    void _onAcquireCountChange(int count);
+
     void _onTorchButtonChange(bool);
     void _onDsoTriggerButtonChange(bool);
 };
@@ -0,0 +1,149 @@
+#include "masktest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+//=============================================================================
+MaskTest::MaskTest()
+    : m_gridUnits(false), m_samples(0), m_unitsPerDiv(0.0f), m_violations(0), m_tested(0), m_failed(0)
+{
+}
+//=============================================================================
+bool MaskTest::load(const std::string& path, uint32_t hDivisions, std::string* error)
+{
+    std::ifstream f(path);
+    if (!f)
+    {
+        if (error) *error = "can't open " + path;
+        return false;
+    }
+
+    std::vector<Point> upper, lower;
+    std::string line;
+    int n = 0;
+
+    while (std::getline(f, line))
+    {
+        n++;
+        std::istringstream in(line.substr(0, line.find('#')));
+
+        std::string which;
+        if (!(in >> which)) continue;
+
+        Point p;
+        if ((which != "upper" && which != "lower") || !(in >> p.x >> p.y))
+        {
+            if (error) *error = path + ":" + std::to_string(n) + ": expected upper|lower <x> <y>";
+            return false;
+        }
+
+        p.x /= hDivisions;
+        (which == "upper" ? upper : lower).push_back(p);
+    }
+
+    if (upper.empty() || lower.empty())
+    {
+        if (error) *error = path + ": both envelopes are needed";
+        return false;
+    }
+
+    auto byX = [](const Point& a, const Point& b) { return a.x < b.x; };
+    std::stable_sort(upper.begin(), upper.end(), byX);
+    std::stable_sort(lower.begin(), lower.end(), byX);
+
+    m_upperPts  = upper;
+    m_lowerPts  = lower;
+    m_gridUnits = true;
+    m_samples   = 0;  // rebuild the bounds on the next capture
+
+    return true;
+}
+//=============================================================================
+void MaskTest::fromReference(const float* ref, uint32_t n, float tolerance)
+{
+    m_upperPts.resize(n);
+    m_lowerPts.resize(n);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float x       = n > 1 ? float(i) / (n - 1) : 0.0f;
+        m_upperPts[i] = {x, ref[i] + tolerance};
+        m_lowerPts[i] = {x, ref[i] - tolerance};
+    }
+
+    m_gridUnits = false;
+    m_samples   = 0;
+}
+//=============================================================================
+void MaskTest::clear()
+{
+    m_upperPts.clear();
+    m_lowerPts.clear();
+    m_upper.clear();
+    m_lower.clear();
+    m_samples = 0;
+}
+//=============================================================================
+// linear interpolation of the envelope at every sample position
+void MaskTest::_resample(const std::vector<Point>& pts, float scale, std::vector<float>& out) const
+{
+    out.resize(m_samples);
+
+    size_t j = 0;
+    for (uint32_t i = 0; i < m_samples; i++)
+    {
+        float x = m_samples > 1 ? float(i) / (m_samples - 1) : 0.0f;
+        while (j + 1 < pts.size() && pts[j + 1].x < x) j++;
+
+        const Point& a = pts[j];
+        const Point& b = j + 1 < pts.size() ? pts[j + 1] : a;
+
+        float y;
+        if (x <= a.x || b.x <= a.x) y = a.y;
+        else if (x >= b.x) y = b.y;
+        else
+            y = a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x);
+
+        out[i] = y * scale;
+    }
+}
+//=============================================================================
+void MaskTest::begin(uint32_t samples, float unitsPerDiv)
+{
+    m_violations = 0;
+    if (!isValid()) return;
+
+    if (samples == m_samples && (!m_gridUnits || unitsPerDiv == m_unitsPerDiv)) return;
+
+    m_samples     = samples;
+    m_unitsPerDiv = unitsPerDiv;
+
+    float scale = m_gridUnits ? unitsPerDiv : 1.0f;
+    _resample(m_upperPts, scale, m_upper);
+    _resample(m_lowerPts, scale, m_lower);
+}
+//=============================================================================
+void MaskTest::block(const float* x, uint32_t offset, uint32_t n)
+{
+    if (offset >= m_upper.size()) return;
+    if (n > m_upper.size() - offset) n = uint32_t(m_upper.size() - offset);
+
+    const float* up = m_upper.data() + offset;
+    const float* lo = m_lower.data() + offset;
+
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < n; i++) bad += (x[i] > up[i]) | (x[i] < lo[i]);
+
+    m_violations += bad;
+}
+//=============================================================================
+bool MaskTest::end()
+{
+    m_tested++;
+    if (!m_violations) return true;
+
+    m_failed++;
+    return false;
+}
+//=============================================================================
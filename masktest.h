@@ -0,0 +1,68 @@
+#ifndef MASKTEST_H
+#define MASKTEST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pass/fail mask testing of DSO captures. The mask is an upper and a lower
+// envelope, either drawn on the oscilloscope grid (a mask file) or taken
+// from a reference waveform +- a tolerance. The envelopes are resampled to
+// one bound per sample only when the capture geometry changes, after that
+// testing a block is a branchless compare-and-count pass.
+//
+// Mask file, piecewise linear envelopes in grid divisions ('#' comments):
+//
+//   upper <x div> <y div>
+//   lower <x div> <y div>
+//
+// x from 0 to the number of horizontal divisions, y in vertical divisions
+// (y * units per division is the bound in the capture unit).
+
+class MaskTest
+{
+   public:
+    MaskTest();
+
+    bool load(const std::string& path, uint32_t hDivisions, std::string* error = nullptr);
+    void fromReference(const float* ref, uint32_t n, float tolerance);
+    void clear();
+
+    bool isValid() const { return !m_upperPts.empty() && !m_lowerPts.empty(); }
+
+    // a new capture of `samples` samples, `unitsPerDiv` vertical scale
+    void begin(uint32_t samples, float unitsPerDiv);
+
+    // tests `n` samples starting at sample `offset` of the capture
+    void block(const float* x, uint32_t offset, uint32_t n);
+
+    // closes the capture, true when every sample was within the mask
+    bool end();
+
+    uint32_t violations() const { return m_violations; }
+    uint64_t tested() const { return m_tested; }
+    uint64_t failed() const { return m_failed; }
+    void resetCounters() { m_tested = m_failed = 0; }
+
+   private:
+    struct Point
+    {
+        float x;  // 0~1 of the capture window
+        float y;
+    };
+
+    std::vector<Point> m_upperPts, m_lowerPts;
+    bool m_gridUnits;  // y in divisions, scaled by unitsPerDiv
+
+    // per sample bounds of the current geometry
+    std::vector<float> m_upper, m_lower;
+    uint32_t m_samples;
+    float m_unitsPerDiv;
+
+    uint32_t m_violations;
+    uint64_t m_tested, m_failed;
+
+    void _resample(const std::vector<Point>& pts, float scale, std::vector<float>& out) const;
+};
+
+#endif  // MASKTEST_H
@@ -0,0 +1,462 @@
+#include "mathchannel.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#define math_max_depth 16
+#define math_max_window 65536u
+
+//=============================================================================
+const char* mathOpName(MathOp op)
+{
+    static const char* names[] = {"Off", "A × B", "A − B", "∫ A dt", "dA/dt", "Moving avg", "Expression"};
+    static_assert(sizeof(names) / sizeof(names[0]) == MO_Count, "one name per MathOp");
+
+    return op < MO_Count ? names[op] : "";
+}
+//=============================================================================
+namespace
+{
+// recursive descent, emits postfix code:
+//   expr  := term (('+' | '-') term)*
+//   term  := unary (('*' | '/') unary)*
+//   unary := '-' unary | power
+//   power := atom ('^' unary)?
+//   atom  := number | a | b | t | pi | func '(' expr ')' | '(' expr ')'
+struct ExprParser
+{
+    const char* p;
+    std::string error;
+    std::vector<MathExprOp> ops;
+    std::vector<float> consts;
+
+    void skip()
+    {
+        while (isspace((unsigned char)*p)) p++;
+    }
+
+    bool accept(char c)
+    {
+        skip();
+        if (*p != c) return false;
+        p++;
+        return true;
+    }
+
+    void emit(MathExprOp op, float k = 0.0f)
+    {
+        ops.push_back(op);
+        consts.push_back(k);
+    }
+
+    bool fail(const char* msg)
+    {
+        if (error.empty()) error = msg;
+        return false;
+    }
+
+    bool expr()
+    {
+        if (!term()) return false;
+        for (;;)
+        {
+            if (accept('+'))
+            {
+                if (!term()) return false;
+                emit(ME_Add);
+            }
+            else if (accept('-'))
+            {
+                if (!term()) return false;
+                emit(ME_Sub);
+            }
+            else
+                return true;
+        }
+    }
+
+    bool term()
+    {
+        if (!unary()) return false;
+        for (;;)
+        {
+            if (accept('*'))
+            {
+                if (!unary()) return false;
+                emit(ME_Mul);
+            }
+            else if (accept('/'))
+            {
+                if (!unary()) return false;
+                emit(ME_Div);
+            }
+            else
+                return true;
+        }
+    }
+
+    bool unary()
+    {
+        if (accept('-'))
+        {
+            if (!unary()) return false;
+            emit(ME_Neg);
+            return true;
+        }
+        return power();
+    }
+
+    bool power()
+    {
+        if (!atom()) return false;
+        if (!accept('^')) return true;
+        if (!unary()) return false;
+        emit(ME_Pow);
+        return true;
+    }
+
+    bool atom()
+    {
+        skip();
+
+        if (isdigit((unsigned char)*p) || *p == '.')
+        {
+            char* end;
+            float k = strtof(p, &end);
+            if (end == p) return fail("bad number");
+            p = end;
+            emit(ME_Const, k);
+            return true;
+        }
+
+        if (accept('('))
+        {
+            if (!expr()) return false;
+            return accept(')') || fail("missing )");
+        }
+
+        const char* start = p;
+        while (isalnum((unsigned char)*p)) p++;
+        std::string name(start, p - start);
+
+        if (name == "a") emit(ME_A);
+        else if (name == "b") emit(ME_B);
+        else if (name == "t") emit(ME_T);
+        else if (name == "pi") emit(ME_Const, (float)M_PI);
+        else
+        {
+            static const struct
+            {
+                const char* name;
+                MathExprOp op;
+            } funcs[] = {{"abs", ME_Abs}, {"sqrt", ME_Sqrt}, {"exp", ME_Exp},
+                         {"log", ME_Log}, {"sin", ME_Sin},   {"cos", ME_Cos}};
+
+            for (const auto& f : funcs)
+            {
+                if (name != f.name) continue;
+                if (!accept('(')) return fail("missing ( after function");
+                if (!expr()) return false;
+                if (!accept(')')) return fail("missing )");
+                emit(f.op);
+                return true;
+            }
+
+            return fail(name.empty() ? "unexpected character" : "unknown name");
+        }
+
+        return true;
+    }
+};
+}  // namespace
+//=============================================================================
+MathExpression::MathExpression() {}
+//=============================================================================
+bool MathExpression::compile(const std::string& text, std::string* error)
+{
+    ExprParser parser;
+    parser.p = text.c_str();
+
+    bool ok = parser.expr();
+    parser.skip();
+    if (ok && *parser.p) ok = parser.fail("trailing characters");
+
+    // stack depth of the program, every chunk of the stack is a fixed buffer
+    uint32_t depth = 0, maxDepth = 0;
+    for (size_t i = 0; ok && i < parser.ops.size(); i++)
+    {
+        switch (parser.ops[i])
+        {
+            case ME_Const:
+            case ME_A:
+            case ME_B:
+            case ME_T:
+                depth++;
+                break;
+            case ME_Add:
+            case ME_Sub:
+            case ME_Mul:
+            case ME_Div:
+            case ME_Pow:
+                depth--;
+                break;
+            default:
+                break;
+        }
+        if (depth > maxDepth) maxDepth = depth;
+    }
+    if (ok && maxDepth > math_max_depth) ok = parser.fail("expression too deep");
+
+    if (!ok)
+    {
+        if (error) *error = parser.error;
+        return false;
+    }
+
+    m_code.clear();
+    for (size_t i = 0; i < parser.ops.size(); i++) m_code.push_back({parser.ops[i], parser.consts[i]});
+
+    return true;
+}
+//=============================================================================
+void MathExpression::eval(const float* a, const float* b, const float* t, uint32_t n, float* out) const
+{
+    if (m_code.empty())
+    {
+        memset(out, 0, n * sizeof(float));
+        return;
+    }
+
+    float stack[math_max_depth][math_chunk];
+    int sp = -1;
+
+    for (const Instr& in : m_code)
+    {
+        switch (in.op)
+        {
+            case ME_Const:
+            {
+                float* d = stack[++sp];
+                for (uint32_t i = 0; i < n; i++) d[i] = in.k;
+                break;
+            }
+            case ME_A:
+                memcpy(stack[++sp], a, n * sizeof(float));
+                break;
+            case ME_B:
+                memcpy(stack[++sp], b, n * sizeof(float));
+                break;
+            case ME_T:
+                memcpy(stack[++sp], t, n * sizeof(float));
+                break;
+            default:
+                break;
+        }
+
+        float* x = stack[sp];
+        float* y = sp > 0 ? stack[sp - 1] : nullptr;  // binary ops: y = y op x
+
+        switch (in.op)
+        {
+            case ME_Add:
+                for (uint32_t i = 0; i < n; i++) y[i] += x[i];
+                sp--;
+                break;
+            case ME_Sub:
+                for (uint32_t i = 0; i < n; i++) y[i] -= x[i];
+                sp--;
+                break;
+            case ME_Mul:
+                for (uint32_t i = 0; i < n; i++) y[i] *= x[i];
+                sp--;
+                break;
+            case ME_Div:
+                for (uint32_t i = 0; i < n; i++) y[i] /= x[i];
+                sp--;
+                break;
+            case ME_Pow:
+                for (uint32_t i = 0; i < n; i++) y[i] = powf(y[i], x[i]);
+                sp--;
+                break;
+            case ME_Neg:
+                for (uint32_t i = 0; i < n; i++) x[i] = -x[i];
+                break;
+            case ME_Abs:
+                for (uint32_t i = 0; i < n; i++) x[i] = fabsf(x[i]);
+                break;
+            case ME_Sqrt:
+                for (uint32_t i = 0; i < n; i++) x[i] = sqrtf(x[i]);
+                break;
+            case ME_Exp:
+                for (uint32_t i = 0; i < n; i++) x[i] = expf(x[i]);
+                break;
+            case ME_Log:
+                for (uint32_t i = 0; i < n; i++) x[i] = logf(x[i]);
+                break;
+            case ME_Sin:
+                for (uint32_t i = 0; i < n; i++) x[i] = sinf(x[i]);
+                break;
+            case ME_Cos:
+                for (uint32_t i = 0; i < n; i++) x[i] = cosf(x[i]);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // the display can't draw NaN/inf (log of a negative, division by zero)
+    for (uint32_t i = 0; i < n; i++) out[i] = std::isfinite(stack[0][i]) ? stack[0][i] : 0.0f;
+}
+//=============================================================================
+MathChannel::MathChannel()
+    : m_op(MO_Off),
+      m_dt(0.0),
+      m_pos(0),
+      m_peak(0.0f),
+      m_integral(0.0),
+      m_prev(0.0f),
+      m_window(16),
+      m_windowPos(0),
+      m_windowFill(0),
+      m_windowSum(0.0)
+{
+}
+//=============================================================================
+void MathChannel::setWindow(uint32_t samples)
+{
+    if (samples < 1) samples = 1;
+    if (samples > math_max_window) samples = math_max_window;
+
+    m_window.assign(samples, 0.0f);
+    m_windowPos  = 0;
+    m_windowFill = 0;
+    m_windowSum  = 0.0;
+}
+//=============================================================================
+bool MathChannel::setExpression(const std::string& text, std::string* error) { return m_expr.compile(text, error); }
+//=============================================================================
+void MathChannel::reset(double dt)
+{
+    m_dt       = dt;
+    m_pos      = 0;
+    m_peak     = 0.0f;
+    m_integral = 0.0;
+    m_prev     = 0.0f;
+
+    setWindow((uint32_t)m_window.size());
+}
+//=============================================================================
+// reference samples [m_pos, m_pos + n), zero padded past its end
+const float* MathChannel::_b(uint32_t n, float* scratch) const
+{
+    uint32_t refSize = (uint32_t)m_reference.size();
+    if (m_pos + n <= refSize) return m_reference.data() + m_pos;
+
+    uint32_t avail = m_pos < refSize ? refSize - m_pos : 0;
+    if (avail) memcpy(scratch, m_reference.data() + m_pos, avail * sizeof(float));
+    memset(scratch + avail, 0, (n - avail) * sizeof(float));
+    return scratch;
+}
+//=============================================================================
+void MathChannel::process(const float* a, uint32_t n, float* out)
+{
+    float scratch[math_chunk], t[math_chunk];
+
+    // chunked so that the reference padding and the time axis fit the stack
+    for (uint32_t done = 0; done < n;)
+    {
+        uint32_t c      = n - done < math_chunk ? n - done : math_chunk;
+        const float* ca = a + done;
+        float* co       = out + done;
+
+        switch (m_op)
+        {
+            case MO_Product:
+            {
+                const float* b = _b(c, scratch);
+                for (uint32_t i = 0; i < c; i++) co[i] = ca[i] * b[i];
+                break;
+            }
+            case MO_Difference:
+            {
+                const float* b = _b(c, scratch);
+                for (uint32_t i = 0; i < c; i++) co[i] = ca[i] - b[i];
+                break;
+            }
+            case MO_Integral:
+            {
+                double half = m_dt * 0.5;
+                uint32_t i  = 0;
+                if (m_pos == 0) co[i++] = 0.0f;
+                float prev = m_pos == 0 ? ca[0] : m_prev;
+                for (; i < c; i++)
+                {
+                    m_integral += (prev + ca[i]) * half;
+                    prev  = ca[i];
+                    co[i] = (float)m_integral;
+                }
+                m_prev = prev;
+                break;
+            }
+            case MO_Derivative:
+            {
+                float inv  = m_dt > 0.0 ? float(1.0 / m_dt) : 0.0f;
+                uint32_t i = 0;
+                if (m_pos == 0) co[i++] = 0.0f;
+                float prev = m_pos == 0 ? ca[0] : m_prev;
+                for (; i < c; i++)
+                {
+                    co[i] = (ca[i] - prev) * inv;
+                    prev  = ca[i];
+                }
+                m_prev = prev;
+                break;
+            }
+            case MO_MovingAverage:
+            {
+                uint32_t w = (uint32_t)m_window.size();
+                for (uint32_t i = 0; i < c; i++)
+                {
+                    if (m_windowFill < w) m_windowFill++;
+                    else
+                        m_windowSum -= m_window[m_windowPos];
+
+                    m_windowSum += ca[i];
+                    m_window[m_windowPos] = ca[i];
+                    co[i]                 = float(m_windowSum / m_windowFill);
+
+                    if (++m_windowPos == w)
+                    {
+                        // once per window: resum to stop rounding drift
+                        m_windowPos = 0;
+                        m_windowSum = 0.0;
+                        for (float x : m_window) m_windowSum += x;
+                    }
+                }
+                break;
+            }
+            case MO_Expression:
+            {
+                const float* b = _b(c, scratch);
+                for (uint32_t i = 0; i < c; i++) t[i] = float((m_pos + i) * m_dt);
+                m_expr.eval(ca, b, t, c, co);
+                break;
+            }
+            default:
+                memset(co, 0, c * sizeof(float));
+                break;
+        }
+
+        for (uint32_t i = 0; i < c; i++)
+        {
+            float v = fabsf(co[i]);
+            m_peak  = v > m_peak ? v : m_peak;
+        }
+
+        m_pos += c;
+        done += c;
+    }
+}
+//=============================================================================
@@ -0,0 +1,118 @@
+#ifndef MATHCHANNEL_H
+#define MATHCHANNEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Math channel of the oscilloscope. Operand `a` is the live capture, `b` a
+// stored reference waveform (e.g. the DOM_VDC capture to combine with the
+// DOM_ADC one), sample aligned with `a`; samples past the end of the
+// reference read as 0. Every op is evaluated block by block as the capture
+// arrives, carrying its state (running integral, previous sample, moving
+// average window) from one block to the next.
+
+enum MathOp : uint8_t
+{
+    MO_Off           = 0,
+    MO_Product       = 1,  // a * b
+    MO_Difference    = 2,  // a - b
+    MO_Integral      = 3,  // trapezoidal, of a over time
+    MO_Derivative    = 4,  // of a over time
+    MO_MovingAverage = 5,  // of a, over `window` samples
+    MO_Expression    = 6,  // user expression of a, b and t
+    MO_Count,
+};
+
+const char* mathOpName(MathOp op);
+
+#define math_chunk 64u
+
+enum MathExprOp : uint8_t
+{
+    ME_Const,
+    ME_A,
+    ME_B,
+    ME_T,
+    ME_Add,
+    ME_Sub,
+    ME_Mul,
+    ME_Div,
+    ME_Pow,
+    ME_Neg,
+    ME_Abs,
+    ME_Sqrt,
+    ME_Exp,
+    ME_Log,
+    ME_Sin,
+    ME_Cos,
+};
+
+// User expression compiled to a postfix program, e.g. "a*b", "abs(a-b)",
+// "(a-0.5)^2", "a*sin(6.2832*50*t)". Every instruction works on a whole
+// chunk of samples, so the inner loops are plain array loops.
+class MathExpression
+{
+   public:
+    MathExpression();
+
+    // on failure the previous program is kept and `error` tells why
+    bool compile(const std::string& text, std::string* error = nullptr);
+    bool isValid() const { return !m_code.empty(); }
+
+    // n <= math_chunk
+    void eval(const float* a, const float* b, const float* t, uint32_t n, float* out) const;
+
+   private:
+    struct Instr
+    {
+        MathExprOp op;
+        float k;  // ME_Const only
+    };
+
+    std::vector<Instr> m_code;
+};
+
+class MathChannel
+{
+   public:
+    MathChannel();
+
+    void setOp(MathOp op) { m_op = op; }
+    MathOp op() const { return m_op; }
+    void setWindow(uint32_t samples);
+    bool setExpression(const std::string& text, std::string* error = nullptr);
+
+    void setReference(const float* data, uint32_t n) { m_reference.assign(data, data + n); }
+    void clearReference() { m_reference.clear(); }
+    const std::vector<float>& reference() const { return m_reference; }
+
+    // starts a new capture, `dt` is the sample period in seconds
+    void reset(double dt);
+
+    // evaluates the next `n` samples of the capture into `out`
+    void process(const float* a, uint32_t n, float* out);
+
+    // largest absolute output since reset(), to scale the display
+    float peak() const { return m_peak; }
+
+   private:
+    MathOp m_op;
+    MathExpression m_expr;
+    std::vector<float> m_reference;
+
+    double m_dt;
+    uint32_t m_pos;  // samples processed since reset()
+    float m_peak;
+
+    double m_integral;
+    float m_prev;
+
+    std::vector<float> m_window;  // moving average ring
+    uint32_t m_windowPos, m_windowFill;
+    double m_windowSum;
+
+    const float* _b(uint32_t n, float* scratch) const;
+};
+
+#endif  // MATHCHANNEL_H
@@ -0,0 +1,135 @@
+#include "perf.h"
+
+#include <cstring>
+
+struct PerfThreadData
+{
+    std::atomic<uint64_t> bins[PS_Count][perf_bins];
+    std::atomic<uint64_t> count[PS_Count];
+    std::atomic<uint64_t> total[PS_Count];
+    PerfThreadData* next;
+};
+
+// every thread that ever recorded a sample, never freed so that a snapshot
+// can keep reading the data of threads that already exited
+static std::atomic<PerfThreadData*> s_threads{nullptr};
+
+//=============================================================================
+static PerfThreadData* _registerThread()
+{
+    PerfThreadData* d = new PerfThreadData();
+    for (int s = 0; s < PS_Count; s++)
+    {
+        for (int b = 0; b < perf_bins; b++) d->bins[s][b].store(0, std::memory_order_relaxed);
+        d->count[s].store(0, std::memory_order_relaxed);
+        d->total[s].store(0, std::memory_order_relaxed);
+    }
+
+    d->next = s_threads.load(std::memory_order_relaxed);
+    while (!s_threads.compare_exchange_weak(d->next, d, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    return d;
+}
+//=============================================================================
+static inline int _bin(uint64_t ns)
+{
+    if (ns < 16) return (int)ns;
+    int e   = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (e - 2)) & 3;
+    return 16 + (e - 4) * 4 + sub;
+}
+//=============================================================================
+static inline double _binLow(int bin)
+{
+    if (bin < 16) return bin;
+    int e   = (bin - 16) / 4 + 4;
+    int sub = (bin - 16) % 4;
+    return double(uint64_t(4 + sub) << (e - 2));
+}
+//=============================================================================
+static inline double _binHigh(int bin)
+{
+    if (bin < 16) return bin + 1;
+    int e = (bin - 16) / 4 + 4;
+    return _binLow(bin) + double(uint64_t(1) << (e - 2));
+}
+//=============================================================================
+void perfRecord(PerfStage stage, uint64_t ns)
+{
+    static thread_local PerfThreadData* d = _registerThread();
+
+    // single writer: a relaxed load+store is enough and avoids a locked add
+    auto bump = [](std::atomic<uint64_t>& a, uint64_t v)
+    { a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed); };
+
+    bump(d->bins[stage][_bin(ns)], 1);
+    bump(d->count[stage], 1);
+    bump(d->total[stage], ns);
+}
+//=============================================================================
+PerfSnapshot perfSnapshot()
+{
+    PerfSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+
+    for (PerfThreadData* d = s_threads.load(std::memory_order_acquire); d; d = d->next)
+    {
+        for (int s = 0; s < PS_Count; s++)
+        {
+            PerfHistogram& h = snap.stages[s];
+            for (int b = 0; b < perf_bins; b++) h.bins[b] += d->bins[s][b].load(std::memory_order_relaxed);
+            h.count += d->count[s].load(std::memory_order_relaxed);
+            h.total += d->total[s].load(std::memory_order_relaxed);
+        }
+    }
+
+    return snap;
+}
+//=============================================================================
+PerfSnapshot PerfSnapshot::operator-(const PerfSnapshot& older) const
+{
+    PerfSnapshot diff;
+
+    for (int s = 0; s < PS_Count; s++)
+    {
+        for (int b = 0; b < perf_bins; b++) diff.stages[s].bins[b] = stages[s].bins[b] - older.stages[s].bins[b];
+        diff.stages[s].count = stages[s].count - older.stages[s].count;
+        diff.stages[s].total = stages[s].total - older.stages[s].total;
+    }
+
+    return diff;
+}
+//=============================================================================
+double PerfHistogram::percentile(double q) const
+{
+    if (!count) return 0.0;
+
+    // bins are summed without a lock, count may be slightly ahead of them
+    uint64_t n = 0;
+    for (int b = 0; b < perf_bins; b++) n += bins[b];
+    if (!n) return 0.0;
+
+    double rank = q * double(n);
+    uint64_t acc = 0;
+
+    for (int b = 0; b < perf_bins; b++)
+    {
+        if (!bins[b]) continue;
+        if (double(acc + bins[b]) >= rank)
+        {
+            double f = (rank - double(acc)) / double(bins[b]);
+            return _binLow(b) + f * (_binHigh(b) - _binLow(b));
+        }
+        acc += bins[b];
+    }
+
+    return _binHigh(perf_bins - 1);
+}
+//=============================================================================
+const char* perfStageName(PerfStage stage)
+{
+    static const char* names[] = {"receive", "decode", "widget", "repaint"};
+    return stage < PS_Count ? names[stage] : "";
+}
+//=============================================================================
@@ -0,0 +1,79 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Hot path timers. Every thread owns its own set of histograms (single
+// writer, relaxed atomics), readers sum them up without taking any lock.
+// Configure with -DGOKIT_PERF=ON to compile them in: otherwise PERF_SCOPE
+// expands to nothing and no clock is ever read.
+
+enum PerfStage : uint8_t
+{
+    PS_Receive = 0,  // whole charValueUpdated
+    PS_Decode  = 1,  // payload validation and decoding
+    PS_Widget  = 2,  // widget updates triggered by a notification
+    PS_Repaint = 3,  // paint events, application wide
+    PS_Count,
+};
+
+// log2 buckets split in 4 linear sub-buckets: values below 16ns are exact,
+// above that the relative error is at most 25%
+#define perf_bins 256
+
+struct PerfHistogram
+{
+    uint64_t bins[perf_bins];
+    uint64_t count;
+    uint64_t total;  // in ns
+
+    // interpolated value (ns) below which `q` (0~1) of the samples fall
+    double percentile(double q) const;
+};
+
+struct PerfSnapshot
+{
+    PerfHistogram stages[PS_Count];
+
+    PerfSnapshot operator-(const PerfSnapshot& older) const;
+};
+
+const char* perfStageName(PerfStage stage);
+
+// sum of every thread's histograms since startup
+PerfSnapshot perfSnapshot();
+
+void perfRecord(PerfStage stage, uint64_t ns);
+
+class PerfScope
+{
+   public:
+    explicit PerfScope(PerfStage stage) : m_stage(stage), m_start(std::chrono::steady_clock::now()) {}
+    ~PerfScope()
+    {
+        auto dt = std::chrono::steady_clock::now() - m_start;
+        perfRecord(m_stage, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+    }
+
+    PerfScope(const PerfScope&)            = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+   private:
+    PerfStage m_stage;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+
+#ifdef GOKIT_PERF
+#define PERF_ENABLED true
+#define PERF_SCOPE(stage) PerfScope PERF_CONCAT(_perfscope_, __LINE__)(stage)
+#else
+#define PERF_ENABLED false
+#define PERF_SCOPE(stage) ((void)0)
+#endif
+
+#endif  // PERF_H
@@ -0,0 +1,72 @@
+#include "perfoverlay.h"
+
+#include <QEvent>
+#include <QFontDatabase>
+
+//=============================================================================
+PerfOverlay::PerfOverlay(QWidget* parent) : QLabel(parent), m_last(perfSnapshot())
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setStyleSheet("background-color: rgba(0, 0, 0, 180); color: #40ff40; padding: 6px;");
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    hide();
+
+    parent->installEventFilter(this);
+}
+//=============================================================================
+void PerfOverlay::toggle()
+{
+    setVisible(!isVisible());
+    if (isVisible())
+    {
+        raise();
+        _reposition();
+    }
+}
+//=============================================================================
+void PerfOverlay::refresh(double seconds, const QStringList& extra)
+{
+    PerfSnapshot now  = perfSnapshot();
+    PerfSnapshot diff = now - m_last;
+    m_last            = now;
+
+    if (!isVisible()) return;
+    if (seconds <= 0.0) seconds = 1.0;
+
+    QStringList lines;
+
+#if PERF_ENABLED == true
+    lines << QString("%1 %2 %3 %4").arg("stage", -8).arg("ev/s", 8).arg("p50 us", 9).arg("p99 us", 9);
+    for (int s = 0; s < PS_Count; s++)
+    {
+        const PerfHistogram& h = diff.stages[s];
+        lines << QString("%1 %2 %3 %4")
+                     .arg(perfStageName((PerfStage)s), -8)
+                     .arg(double(h.count) / seconds, 8, 'f', 1)
+                     .arg(h.percentile(0.5) / 1000.0, 9, 'f', 2)
+                     .arg(h.percentile(0.99) / 1000.0, 9, 'f', 2);
+    }
+#else
+    lines << "stage timers compiled out (GOKIT_PERF=OFF)";
+#endif
+
+    if (!extra.isEmpty()) lines << "" << extra;
+
+    setText(lines.join('\n'));
+    adjustSize();
+    _reposition();
+}
+//=============================================================================
+bool PerfOverlay::eventFilter(QObject* obj, QEvent* event)
+{
+    if (obj == parent() && event->type() == QEvent::Resize) _reposition();
+    return QLabel::eventFilter(obj, event);
+}
+//=============================================================================
+void PerfOverlay::_reposition()
+{
+    QWidget* p = parentWidget();
+    if (!p) return;
+    move(p->width() - width() - 8, 8);
+}
+//=============================================================================
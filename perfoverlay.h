@@ -0,0 +1,31 @@
+#ifndef PERFOVERLAY_H
+#define PERFOVERLAY_H
+
+#include "perf.h"
+
+#include <QLabel>
+#include <QStringList>
+
+// Translucent panel drawn over the top right corner of its parent, showing
+// the rate and p50/p99 latency of every perf stage over the last refresh
+// period, followed by any caller provided line.
+class PerfOverlay : public QLabel
+{
+   public:
+    PerfOverlay(QWidget* parent);
+
+    void toggle();
+
+    // `seconds` is the time elapsed since the previous refresh
+    void refresh(double seconds, const QStringList& extra);
+
+   protected:
+    virtual bool eventFilter(QObject* obj, QEvent* event) override;
+
+   private:
+    PerfSnapshot m_last;
+
+    void _reposition();
+};
+
+#endif  // PERFOVERLAY_H
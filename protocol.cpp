@@ -0,0 +1,173 @@
+#include "protocol.h"
+
+#include "ranges.h"
+
+#include <cstddef>
+#include <cstring>
+
+// sizes of the documented part of each payload
+#define device_data_min_size sizeof(DeviceData)
+#define device_status_min_size offsetof(DeviceStatus, spare0)
+#define mm_reading_min_size sizeof(MMReading)
+#define device_button_min_size sizeof(DeviceButton)
+#define dso_metadata_min_size offsetof(DSOMetadata, spare0)
+
+#define dso_max_samples 8192u
+
+//=============================================================================
+// copies at most sizeof(T) bytes into a zeroed T, so that the validation
+// below always reads initialized memory regardless of the payload length
+template <typename T>
+static inline T _load(const uint8_t* data, uint32_t size)
+{
+    T x;
+    memset(&x, 0, sizeof(x));
+    memcpy(&x, data, size < sizeof(x) ? size : sizeof(x));
+    return x;
+}
+//=============================================================================
+// NaN and infinities share the all-ones exponent
+static inline bool _finite(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return (bits & 0x7f800000u) != 0x7f800000u;
+}
+//=============================================================================
+// a range of the mode table, or range_auto where the device autoranges; the
+// modes without ranges (diode, continuity, ...) don't interpret the field
+static inline bool _validRange(const ModeDesc& mode, uint8_t range)
+{
+    return (range < mode.rangeCount) | (mode.autorange & (range == range_auto)) | (mode.rangeCount == 0);
+}
+//=============================================================================
+// the checks are combined with bitwise ands on purpose: one well predicted
+// branch per packet instead of one per field
+bool decodeDeviceData(const uint8_t* data, uint32_t size, DeviceData& out)
+{
+    if (!data || size < device_data_min_size) return false;
+    out = _load<DeviceData>(data, size);
+    return true;
+}
+//=============================================================================
+bool decodeDeviceStatus(const uint8_t* data, uint32_t size, DeviceStatus& out)
+{
+    if (!data || size < device_status_min_size) return false;
+    DeviceStatus x = _load<DeviceStatus>(data, size);
+
+    bool ok = (uint8_t)x.state <= DS_Datalogger;
+    ok &= (uint8_t)x.modeswitch <= MSP_Current;
+    ok &= _finite(x.batteryVoltage) & (x.batteryVoltage >= 0.0f);
+
+    if (ok) out = x;
+    return ok;
+}
+//=============================================================================
+bool decodeMMReading(const uint8_t* data, uint32_t size, MMReading& out)
+{
+    if (!data || size < mm_reading_min_size) return false;
+    MMReading x = _load<MMReading>(data, size);
+
+    bool ok = (uint8_t)x.mode <= MM_Temperature;
+    ok &= _validRange(mmMode(x.mode), x.range);
+    ok &= _finite(x.value);
+
+    if (ok) out = x;
+    return ok;
+}
+//=============================================================================
+bool decodeDeviceButton(const uint8_t* data, uint32_t size, DeviceButton& out)
+{
+    if (!data || size < device_button_min_size) return false;
+    DeviceButton x = _load<DeviceButton>(data, size);
+
+    bool ok = (uint8_t)x.button <= BA_LongPress;
+
+    if (ok) out = x;
+    return ok;
+}
+//=============================================================================
+bool decodeTorch(const uint8_t* data, uint32_t size, uint8_t& out)
+{
+    if (!data || size < 1) return false;
+    bool ok = data[0] <= 1;
+
+    if (ok) out = data[0];
+    return ok;
+}
+//=============================================================================
+bool decodeDSOMetadata(const uint8_t* data, uint32_t size, DSOMetadata& out)
+{
+    if (!data || size < dso_metadata_min_size) return false;
+    DSOMetadata x = _load<DSOMetadata>(data, size);
+
+    uint8_t st = (uint8_t)x.status;
+
+    bool ok = (st <= DS_Sampling) | (st == DS_Error);
+    ok &= (uint8_t)x.mode <= DOM_AAC;
+    ok &= _validRange(dsoMode(x.mode), x.range);
+    ok &= (x.samples > 0) & (x.samples <= dso_max_samples);
+    ok &= _finite(x.scale);
+
+    if (ok) out = x;
+    return ok;
+}
+//=============================================================================
+bool decodeDSOReading(const uint8_t* data, uint32_t size, DSOReading& out, uint32_t& samples)
+{
+    // whole int16 samples only, never more than the struct can hold
+    bool ok = (data != nullptr) & (size > 0) & ((size & 1u) == 0) & (size <= sizeof(DSOReading));
+    if (!ok) return false;
+
+    memcpy(&out, data, size);
+    samples = size / 2;
+    return true;
+}
+//=============================================================================
+const char* pokitCharUuid(PokitChar ch)
+{
+    static const char* uuids[] = {
+        "",
+        pokit_device_ch,
+        pokit_status_ch,
+        pokit_flashled_ch,
+        pokit_torch_ch,
+        pokit_button_ch,
+        pokit_multimeter_setting_ch,
+        pokit_multimeter_reading_ch,
+        pokit_dso_setting_ch,
+        pokit_dso_metadata_ch,
+        pokit_dso_reading_ch,
+    };
+    static_assert(sizeof(uuids) / sizeof(uuids[0]) == PC_Count, "one uuid per PokitChar");
+
+    return ch < PC_Count ? uuids[ch] : "";
+}
+//=============================================================================
+const char* pokitCharName(PokitChar ch)
+{
+    static const char* names[] = {
+        "unknown", "device", "status", "flashled", "torch", "button",
+        "mm_setting", "mm_reading", "dso_setting", "dso_metadata", "dso_reading",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == PC_Count, "one name per PokitChar");
+
+    return ch < PC_Count ? names[ch] : "unknown";
+}
+//=============================================================================
+const char* pokitServiceUuid(PokitService service)
+{
+    static const char* uuids[] = {"", pokit_status_service, pokit_multimeter_service, pokit_dso_service};
+    static_assert(sizeof(uuids) / sizeof(uuids[0]) == PSRV_Count, "one uuid per PokitService");
+
+    return service < PSRV_Count ? uuids[service] : "";
+}
+//=============================================================================
+const char* pokitServiceName(PokitService service)
+{
+    static const char* names[] = {"unknown", "status", "multimeter", "dso"};
+    static_assert(sizeof(names) / sizeof(names[0]) == PSRV_Count, "one name per PokitService");
+
+    return service < PSRV_Count ? names[service] : "unknown";
+}
+//=============================================================================
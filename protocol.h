@@ -0,0 +1,233 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+
+#define pokit_status_service "57D3A771-267C-4394-8872-78223E92AEC5"  // wrong doc (it mentions ..C4)
+#define pokit_device_ch "6974F5E5-0E54-45C3-97DD-29E4B5FB0849"
+#define pokit_status_ch "3dba36e1-6120-4706-8dfd-ed9c16e569b6"
+#define pokit_flashled_ch "ec9bb1f3-05a9-4277-8dd0-60a7896f0d6e"
+#define pokit_torch_ch "aaf3f6d5-43d4-4a83-9510-dff3d858d4cc"   // subscr
+#define pokit_button_ch "8fe5b5a9-b5b4-4a7b-8ff2-87224b970f89"  // subscr
+
+// to confirm:
+#define pokit_multimeter_service "e7481d2f-5781-442e-bb9a-fd4e3441dadc"
+#define pokit_multimeter_setting_ch "53dc9a7a-bc19-4280-b76b-002d0e23b078"
+#define pokit_multimeter_reading_ch "047d3559-8bee-423a-b229-4417fa603b90"  // subsc
+
+#define pokit_dso_service "1569801e-1425-4a7a-b617-a4f4ed719de6"
+#define pokit_dso_setting_ch "a81af1b6-b8b3-4244-8859-3da368d2be39"
+#define pokit_dso_metadata_ch "970f00ba-f46f-4825-96a8-153a5cd0cda9"
+#define pokit_dso_reading_ch "98e14f8e-536e-4f24-b4f4-1debfed0a99e"
+
+// compact identifiers of the characteristics, as stored in trace files
+enum PokitChar : uint8_t
+{
+    PC_Unknown     = 0,
+    PC_Device      = 1,
+    PC_Status      = 2,
+    PC_FlashLed    = 3,
+    PC_Torch       = 4,
+    PC_Button      = 5,
+    PC_MMSetting   = 6,
+    PC_MMReading   = 7,
+    PC_DSOSetting  = 8,
+    PC_DSOMetadata = 9,
+    PC_DSOReading  = 10,
+    PC_Count,
+};
+
+enum PokitService : uint8_t
+{
+    PSRV_Unknown    = 0,
+    PSRV_Status     = 1,
+    PSRV_Multimeter = 2,
+    PSRV_DSO        = 3,
+    PSRV_Count,
+};
+
+enum DeviceState : uint8_t
+{
+    DS_MM_Idle        = 0,
+    DS_MM_DCVoltage   = 1,
+    DS_MM_ACVoltage   = 2,
+    DS_MM_DCCUrrent   = 3,
+    DS_MM_ACCurrent   = 4,
+    DS_MM_Resistance  = 5,
+    DS_MM_Diode       = 6,
+    DS_MM_Continuity  = 7,
+    DS_MM_Temperature = 8,
+    DS_DSO            = 9,
+    DS_Datalogger     = 10,
+};
+
+enum MultimeterMode : uint8_t
+{
+    MM_IDLE        = 0,
+    MM_DCVoltage   = 1,
+    MM_ACVoltage   = 2,
+    MM_DCCurrent   = 3,
+    MM_ACCurrent   = 4,
+    MM_Resistance  = 5,
+    MM_Diode       = 6,
+    MM_Continuity  = 7,
+    MM_Temperature = 8,
+};
+
+enum ModeSwitchPosition : uint8_t
+{
+    MSP_Voltage = 0,
+    MSP_Mixed   = 1,
+    MSP_Current = 2,
+};
+
+enum ButtonAction : uint8_t
+{
+    BA_Release   = 0,
+    BA_Pressed   = 1,
+    BA_LongPress = 2,
+};
+
+enum DSOCommand : uint8_t
+{
+    DSOC_FreeRunning = 0,
+    DSOC_RisingEdge  = 1,
+    DSOC_FallingEdge = 2,
+    DSOC_Resend      = 3,
+    DSOC_Spare0      = 4,  // unknown
+    DSOC_Continuos   = 5,  // undocumented
+};
+
+enum DSOOpMode : uint8_t
+{
+    DOM_Idle = 0,
+    DOM_VDC  = 1,
+    DOM_VAC  = 2,
+    DOM_ADC  = 3,
+    DOM_AAC  = 4,
+};
+
+enum DSOStatus : uint8_t
+{
+    DS_Done     = 0,
+    DS_Sampling = 1,
+    DS_Error    = 255,
+};
+
+#pragma pack(push, 1)
+struct DeviceData
+{
+    uint8_t fwMaj;
+    uint8_t fwMin;
+    uint16_t maxVoltage;       // In V
+    uint16_t maxCurrent;       // In A
+    uint16_t maxResistance;    // In KOhm
+    uint16_t maxSamplingRate;  // in KHz
+    uint16_t maxBufferSize;
+    uint16_t reserved;
+    uint8_t macAddr[6];
+};
+
+struct DeviceStatus
+{
+    DeviceState state;
+    float batteryVoltage;  // cell voltage, up to 4.2v charged (Li-ion), 3.3v on a coin cell
+
+    // undocumented
+    uint8_t spare0;
+    ModeSwitchPosition modeswitch;
+    uint8_t spare1;
+};
+
+struct MMSettings
+{
+    MultimeterMode mode;
+    uint8_t range;
+    uint32_t updateInterval;
+};
+
+struct MMReading
+{
+    uint8_t status;
+    float value;
+    MultimeterMode mode;
+    uint8_t range;
+};
+
+struct DeviceButton
+{
+    uint8_t spare;
+    ButtonAction button;
+};
+
+struct DSOSettings
+{
+    DSOCommand command;
+    float trigger;
+    DSOOpMode mode;
+    uint8_t range;
+    uint32_t window;
+    uint16_t samples;  // 1~8192
+};
+
+struct DSOMetadata
+{
+    DSOStatus status;
+    float scale;
+    DSOOpMode mode;
+    uint8_t range;
+    uint32_t window;
+    uint16_t samples;
+    uint32_t samplingRate;
+
+    // undocumented and unknown data:
+    uint8_t spare0;
+    uint8_t spare1;
+    uint8_t spare2;
+    uint8_t spare3;
+    uint8_t spare4;
+};
+
+struct DSOReading
+{
+    int16_t data[88];  // doc says 10 -_-
+};
+
+#pragma pack(pop)
+
+// Payload decoders for every notified characteristic. Each one checks the
+// payload size and the enum/float fields before touching `out`, so a
+// malformed packet is rejected instead of being trusted as-is.
+// Payloads shorter than the documented part of a struct are rejected,
+// the undocumented trailing fields are zero-filled when missing. Ranges are
+// checked against the mode tables of ranges.h.
+bool decodeDeviceData(const uint8_t* data, uint32_t size, DeviceData& out);
+bool decodeDeviceStatus(const uint8_t* data, uint32_t size, DeviceStatus& out);
+bool decodeMMReading(const uint8_t* data, uint32_t size, MMReading& out);
+bool decodeDeviceButton(const uint8_t* data, uint32_t size, DeviceButton& out);
+bool decodeTorch(const uint8_t* data, uint32_t size, uint8_t& out);
+bool decodeDSOMetadata(const uint8_t* data, uint32_t size, DSOMetadata& out);
+// `samples` receives the number of int16 samples carried by the packet;
+// packets with more samples than a DSOReading holds are rejected, not cut
+bool decodeDSOReading(const uint8_t* data, uint32_t size, DSOReading& out, uint32_t& samples);
+
+const char* pokitCharUuid(PokitChar ch);
+const char* pokitCharName(PokitChar ch);
+const char* pokitServiceUuid(PokitService service);
+const char* pokitServiceName(PokitService service);
+
+// Validation cost bookkeeping, filled by the caller around the decoders
+struct DecodeStats
+{
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t nanos;
+
+    double nsPerPacket() const
+    {
+        uint64_t n = accepted + rejected;
+        return n ? double(nanos) / double(n) : 0.0;
+    }
+};
+
+#endif  // PROTOCOL_H
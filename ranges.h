@@ -0,0 +1,123 @@
+#ifndef RANGES_H
+#define RANGES_H
+
+#include "protocol.h"
+
+// Single source of truth for the multimeter and DSO modes: display names,
+// units and, for every range index the device accepts, its label and full
+// scale value. All the lookups are O(1) indexed accesses into constexpr
+// tables; the static_asserts at the bottom keep the tables consistent.
+
+#define range_auto 255
+
+struct RangeDesc
+{
+    const char* label;
+    float fullScale;  // in the mode unit
+};
+
+struct ModeDesc
+{
+    const char* name;
+    const char* shortName;
+    const char* unit;
+    const RangeDesc* ranges;
+    uint8_t rangeCount;
+    bool autorange;  // the device accepts range_auto for this mode
+};
+
+constexpr RangeDesc voltageRanges[] = {
+    {"0~300mV", 0.3f}, {"300mV~2V", 2.0f}, {"2V~6V", 6.0f},
+    {"6V~12V", 12.0f}, {"12V~30V", 30.0f}, {"30V~60V", 60.0f},
+};
+
+constexpr RangeDesc currentRanges[] = {
+    {"0~10mA", 0.01f}, {"10mA~30mA", 0.03f}, {"30mA~150mA", 0.15f}, {"150mA~300mA", 0.3f}, {"300mA~3A", 3.0f},
+};
+
+constexpr RangeDesc resistanceRanges[] = {
+    {"0~160R", 160.0f},     {"160R~330R", 330.0f},     {"330R~890R", 890.0f},      {"890R~1K5", 1500.0f},
+    {"1K5~10K", 10000.0f}, {"10K~100K", 100000.0f}, {"100K~470K", 470000.0f}, {"470K~1M", 1000000.0f},
+};
+
+#define RANGES(TABLE) TABLE, uint8_t(sizeof(TABLE) / sizeof(TABLE[0]))
+
+// indexed by MultimeterMode
+constexpr ModeDesc mmModes[] = {
+    {"Idle", "Idle", "", nullptr, 0, false},
+    {"DC Voltage", "VDC", "V", RANGES(voltageRanges), true},
+    {"AC Voltage", "VAC", "V", RANGES(voltageRanges), true},
+    {"DC Current", "ADC", "A", RANGES(currentRanges), true},
+    {"AC Current", "AAC", "A", RANGES(currentRanges), true},
+    {"Resistance", "Res", "Ohm", RANGES(resistanceRanges), true},
+    {"Diode", "Diode", "V", nullptr, 0, false},
+    {"Continuity", "Cont", "Ohm", nullptr, 0, false},
+    {"Temperature", "Temp", "C", nullptr, 0, false},
+};
+
+// indexed by DSOOpMode
+constexpr ModeDesc dsoModes[] = {
+    {"Idle", "Idle", "", nullptr, 0, false},
+    {"DC Voltage", "VDC", "V", RANGES(voltageRanges), false},
+    {"AC Voltage", "VAC", "V", RANGES(voltageRanges), false},
+    {"DC Current", "ADC", "A", RANGES(currentRanges), false},
+    {"AC Current", "AAC", "A", RANGES(currentRanges), false},
+};
+
+#undef RANGES
+
+constexpr uint8_t mmModeCount  = sizeof(mmModes) / sizeof(mmModes[0]);
+constexpr uint8_t dsoModeCount = sizeof(dsoModes) / sizeof(dsoModes[0]);
+
+//=============================================================================
+constexpr const ModeDesc& mmMode(MultimeterMode mode)
+{
+    return (uint8_t)mode < mmModeCount ? mmModes[mode] : mmModes[MM_IDLE];
+}
+//=============================================================================
+constexpr const ModeDesc& dsoMode(DSOOpMode mode)
+{
+    return (uint8_t)mode < dsoModeCount ? dsoModes[mode] : dsoModes[DOM_Idle];
+}
+//=============================================================================
+constexpr const char* rangeLabel(const ModeDesc& mode, uint8_t range)
+{
+    if (range == range_auto && mode.autorange) return "AUTO";
+    return range < mode.rangeCount ? mode.ranges[range].label : "---";
+}
+//=============================================================================
+// 1.0 when the range does not exist, so that scaling stays neutral
+constexpr float rangeFullScale(const ModeDesc& mode, uint8_t range)
+{
+    return range < mode.rangeCount ? mode.ranges[range].fullScale : 1.0f;
+}
+//=============================================================================
+constexpr bool _rangesAscending(const RangeDesc* r, uint8_t n)
+{
+    for (uint8_t i = 1; i < n; i++)
+        if (!(r[i - 1].fullScale < r[i].fullScale)) return false;
+    return true;
+}
+//=============================================================================
+constexpr bool _modesValid(const ModeDesc* m, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++)
+    {
+        if (!m[i].name || !m[i].shortName || !m[i].unit) return false;
+        if ((m[i].ranges == nullptr) != (m[i].rangeCount == 0)) return false;
+        if (m[i].autorange && m[i].rangeCount == 0) return false;
+        if (!_rangesAscending(m[i].ranges, m[i].rangeCount)) return false;
+        for (uint8_t j = 0; j < m[i].rangeCount; j++)
+            if (!m[i].ranges[j].label || !(m[i].ranges[j].fullScale > 0.0f)) return false;
+    }
+    return true;
+}
+//=============================================================================
+
+static_assert(mmModeCount == MM_Temperature + 1, "mmModes must have one entry per MultimeterMode");
+static_assert(dsoModeCount == DOM_AAC + 1, "dsoModes must have one entry per DSOOpMode");
+static_assert(_modesValid(mmModes, mmModeCount), "invalid multimeter mode table");
+static_assert(_modesValid(dsoModes, dsoModeCount), "invalid DSO mode table");
+static_assert(sizeof(resistanceRanges) / sizeof(RangeDesc) == 8, "resistance ranges are 0~7 on the wire");
+
+#endif  // RANGES_H
@@ -0,0 +1,152 @@
+#include "sampleclock.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define clock_step_margin 0.25      // of an interval, for an arrival earlier than the fit
+#define clock_offset_quantile 0.05  // of the envelope residuals
+
+//=============================================================================
+ClockFit::ClockFit() { reset(); }
+//=============================================================================
+void ClockFit::reset(double prior)
+{
+    m_points.clear();
+    m_prior     = prior;
+    m_origin    = 0.0;
+    m_slope     = prior;
+    m_intercept = 0.0;
+    m_jitter    = 0.0;
+    m_spread    = 0.0;
+    m_fitted    = false;
+}
+//=============================================================================
+void ClockFit::add(double device, double host)
+{
+    if (!m_points.empty())
+    {
+        Point& last = m_points.back();
+        double bin  = std::floor(device / clock_bin_s);
+        double lbin = std::floor(last.device / clock_bin_s);
+
+        if (bin < lbin) return;  // the device time base never goes back without a reset
+
+        if (bin == lbin)
+        {
+            // same bin: only a less delayed arrival replaces the point
+            if (host - m_slope * device >= last.host - m_slope * last.device) return;
+            last = {device, host};
+            _fit();
+            return;
+        }
+    }
+
+    m_points.push_back({device, host});
+    if (m_points.size() > clock_fit_window) m_points.pop_front();
+    _fit();
+}
+//=============================================================================
+void ClockFit::_fit()
+{
+    size_t n  = m_points.size();
+    m_origin  = m_points.front().device;
+    double h0 = m_points.front().host;
+
+    m_fitted = n >= clock_fit_min;
+    m_slope  = m_prior;
+    m_spread = 0.0;
+
+    if (m_fitted)
+    {
+        double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        for (const Point& p : m_points)
+        {
+            double x = p.device - m_origin, y = p.host - h0;
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+
+        double d = n * sxx - sx * sx;
+        m_spread = d / n;
+        if (d > 0.0)
+            m_slope = (n * sxy - sx * sy) / d;
+        else
+            m_fitted = false;
+    }
+
+    // offset on a low quantile of the residuals: the lowest point for the
+    // few of a short capture, some miscounted readings can't drag it down
+    double sum = 0.0, sumSq = 0.0;
+    m_residuals.clear();
+    for (const Point& p : m_points)
+    {
+        double r = p.host - h0 - m_slope * (p.device - m_origin);
+        m_residuals.push_back(r);
+        sum += r;
+        sumSq += r * r;
+    }
+
+    auto low = m_residuals.begin() + (size_t)(n * clock_offset_quantile);
+    std::nth_element(m_residuals.begin(), low, m_residuals.end());
+
+    double mean = sum / n;
+    m_intercept = h0 + *low;
+    m_jitter    = std::sqrt(std::max(0.0, sumSq / n - mean * mean));
+}
+//=============================================================================
+ReadingClock::ReadingClock() : m_interval(0.0), m_index(0), m_started(false) {}
+//=============================================================================
+void ReadingClock::setInterval(double interval)
+{
+    if (interval == m_interval) return;
+
+    m_fit.restart();
+    m_interval = interval;
+    m_index    = 0;
+    m_started  = false;
+}
+//=============================================================================
+double ReadingClock::reading(double host)
+{
+    if (m_interval <= 0.0) return host;
+
+    if (m_started)
+    {
+        // readings lost on the way still took their interval on the device,
+        // counted from the fitted arrival time of the previous one. A reading
+        // that doesn't reach the next slot (a burst after a radio gap, or the
+        // one after a reading so late it was counted a slot ahead) takes the
+        // slot of the previous one, so a miscount never carries over.
+        double prev = m_fit.host(m_index * m_interval);
+        long steps  = (long)std::floor((host - prev) / (m_interval * m_fit.slope()) + clock_step_margin);
+        if (steps > 0) m_index += steps;
+    }
+
+    m_started = true;
+
+    double device = m_index * m_interval;
+    m_fit.add(device, host);
+    return m_fit.host(device);
+}
+//=============================================================================
+CaptureClock::CaptureClock() : m_period(0.0), m_rate(1.0) {}
+//=============================================================================
+void CaptureClock::begin(double period, double rate)
+{
+    // a capture of a few seconds fits its rate to hundreds of ppm, worse
+    // than no correction at all
+    if (m_fit.fitted() && m_fit.slopeError() < clock_rate_max_error) m_rate = m_fit.slope();
+
+    m_fit.reset(rate > 0.0 ? rate : m_rate);
+    m_period = period;
+}
+//=============================================================================
+double CaptureClock::block(uint32_t offset, uint32_t n, double host)
+{
+    // received once its last sample is taken
+    m_fit.add((double)(offset + n) * m_period, host);
+    return time(offset);
+}
+//=============================================================================
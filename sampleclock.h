@@ -0,0 +1,116 @@
+#ifndef SAMPLECLOCK_H
+#define SAMPLECLOCK_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#define clock_bin_s 1.0             // one fit point per second of device time
+#define clock_fit_window 600u       // points, ten minutes of device time
+#define clock_fit_min 8u            // points before the slope is fitted
+#define clock_rate_max_error 10e-6  // of a capture fit, to carry its rate over
+
+// Sliding linear fit host = a + b * device, all in seconds, of the device
+// clock against the monotonic host receipt time of the notifications.
+//
+// The BLE latency only ever delays a notification, so each bin of device
+// time keeps its least delayed point (the lower envelope), the slope is the
+// least squares fit of those points and the offset is moved down to a low
+// quantile of them: the timestamps follow the earliest arrivals, not the
+// mean latency, and a late burst moves neither slope nor offset. Until
+// enough points are in, the prior slope is used.
+class ClockFit
+{
+   public:
+    ClockFit();
+
+    void reset(double prior = 1.0);
+    void restart() { reset(m_slope); }  // new time base, same device rate
+    void add(double device, double host);
+
+    double host(double device) const { return m_intercept + m_slope * (device - m_origin); }
+
+    double slope() const { return m_slope; }  // host seconds per device second
+    double ppm() const { return (m_slope - 1.0) * 1e6; }
+    double jitter() const { return m_jitter; }  // rms residual of the envelope points, seconds
+    bool fitted() const { return m_fitted; }
+
+    // standard error of the slope, infinite while the prior is used
+    double slopeError() const { return m_fitted ? m_jitter / std::sqrt(m_spread) : INFINITY; }
+    size_t points() const { return m_points.size(); }
+
+   private:
+    struct Point
+    {
+        double device, host;
+    };
+
+    std::deque<Point> m_points;  // one per bin, oldest first
+    std::vector<double> m_residuals;
+    double m_prior;
+    double m_origin;  // device time of the first point, for precision
+    double m_slope, m_intercept, m_jitter;
+    double m_spread;  // of the device times, sum of (x - mean)² over n
+    bool m_fitted;
+
+    void _fit();
+};
+
+// Timestamps of the MM readings. The device produces one every update
+// interval: the reading index gives the device time, readings lost on the
+// way are accounted for from the gap since the previous one.
+class ReadingClock
+{
+   public:
+    ReadingClock();
+
+    // `interval` in seconds, from every settings write: the fit restarts
+    // only when it changes, a range or mode switch keeps it
+    void setInterval(double interval);
+
+    // corrected time of the reading received at `host`
+    double reading(double host);
+
+    const ClockFit& fit() const { return m_fit; }
+
+   private:
+    ClockFit m_fit;
+    double m_interval;
+    uint64_t m_index;
+    bool m_started;
+};
+
+// Timestamps of the samples of a DSO capture: the sample index at the
+// nominal period gives the device time, each block received is a point.
+// The device time base restarts with every capture, so only captures of
+// clock_fit_min seconds or more can fit their own rate, and it is kept for
+// the next ones only when precise enough; the others get the offset from
+// their blocks and the rate from elsewhere.
+class CaptureClock
+{
+   public:
+    CaptureClock();
+
+    // new capture, `period` in seconds. `rate` is the device clock rate
+    // fitted on the MM readings (same oscillator), 0 when there is none:
+    // the rate of the last capture that fitted its own precisely is used then
+    void begin(double period, double rate = 0.0);
+
+    // the block of `n` samples from `offset` was received at `host`,
+    // returns the corrected time of its first sample
+    double block(uint32_t offset, uint32_t n, double host);
+
+    double time(uint32_t i) const { return m_fit.host(i * m_period); }
+    double period() const { return m_period * m_fit.slope(); }  // corrected
+
+    const ClockFit& fit() const { return m_fit; }
+
+   private:
+    ClockFit m_fit;
+    double m_period;  // nominal
+    double m_rate;    // fitted on the last capture precise enough
+};
+
+#endif  // SAMPLECLOCK_H
@@ -0,0 +1,171 @@
+#include "samplecodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+//=============================================================================
+static inline uint32_t _bits(int16_t v) { return uint32_t(int32_t(v)); }
+static inline uint32_t _bits(float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+//=============================================================================
+template <typename T>
+static inline T _from(uint32_t u);
+
+template <>
+inline int16_t _from<int16_t>(uint32_t u)
+{
+    return int16_t(u);
+}
+
+template <>
+inline float _from<float>(uint32_t u)
+{
+    float v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+//=============================================================================
+// small magnitudes of either sign to small unsigned values
+static inline uint32_t _zigzag(uint32_t d) { return (d << 1) ^ uint32_t(int32_t(d) >> 31); }
+static inline uint32_t _unzigzag(uint32_t z) { return (z >> 1) ^ (0u - (z & 1)); }
+//=============================================================================
+static uint8_t* _pack(const uint32_t* z, uint32_t n, uint32_t width, uint8_t* out)
+{
+    uint64_t acc  = 0;
+    uint32_t bits = 0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        acc |= uint64_t(z[i]) << bits;
+        bits += width;
+        while (bits >= 8)
+        {
+            *out++ = uint8_t(acc);
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+
+    if (bits) *out++ = uint8_t(acc);
+    return out;
+}
+//=============================================================================
+static const uint8_t* _unpack(const uint8_t* in, uint32_t n, uint32_t width, uint32_t* z)
+{
+    if (!width)
+    {
+        std::fill(z, z + n, 0u);
+        return in;
+    }
+
+    uint64_t mask = (uint64_t(1) << width) - 1;
+    uint64_t acc  = 0;
+    uint32_t bits = 0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        while (bits < width)
+        {
+            acc |= uint64_t(*in++) << bits;
+            bits += 8;
+        }
+        z[i] = uint32_t(acc & mask);
+        acc >>= width;
+        bits -= width;
+    }
+
+    return in;
+}
+//=============================================================================
+template <typename T>
+static void _encode(const T* x, uint32_t n, std::vector<uint8_t>& out, T from)
+{
+    size_t at = out.size();
+    out.resize(at + codecBound(n));
+    uint8_t* p = out.data() + at;
+
+    uint32_t u[codec_frame + 2], z1[codec_frame], z2[codec_frame];
+    u[0] = u[1] = _bits(from);
+
+    for (uint32_t f = 0; f < n; f += codec_frame)
+    {
+        const T* v     = x + f;
+        uint32_t count = std::min(n - f, codec_frame);
+
+        // u[i + 2] is v[i], preceded by the last two values of the previous frame
+        for (uint32_t i = 0; i < count; i++) u[i + 2] = _bits(v[i]);
+        for (uint32_t i = 0; i < count; i++) z1[i] = _zigzag(u[i + 2] - u[i + 1]);
+        for (uint32_t i = 0; i < count; i++) z2[i] = _zigzag(u[i + 2] - 2 * u[i + 1] + u[i]);
+
+        uint32_t any1 = 0, any2 = 0;
+        for (uint32_t i = 0; i < count; i++) any1 |= z1[i];
+        for (uint32_t i = 0; i < count; i++) any2 |= z2[i];
+
+        uint32_t w1 = any1 ? 32 - __builtin_clz(any1) : 0;
+        uint32_t w2 = any2 ? 32 - __builtin_clz(any2) : 0;
+        bool linear = w2 < w1;
+
+        *p++ = uint8_t(linear ? w2 | codec_linear : w1);
+        p    = _pack(linear ? z2 : z1, count, linear ? w2 : w1, p);
+        u[0] = u[count];
+        u[1] = u[count + 1];
+    }
+
+    out.resize(p - out.data());
+}
+//=============================================================================
+template <typename T>
+static bool _decode(const uint8_t* data, size_t size, T* x, uint32_t n, size_t* used, T from)
+{
+    const uint8_t* p   = data;
+    const uint8_t* end = data + size;
+
+    uint32_t z[codec_frame];
+    uint32_t prev = _bits(from), before = prev;
+
+    for (uint32_t f = 0; f < n; f += codec_frame)
+    {
+        uint32_t count = std::min(n - f, codec_frame);
+
+        if (p >= end) return false;
+        uint32_t tag   = *p++;
+        uint32_t width = tag & ~codec_linear;
+        if (width > 32 || size_t(end - p) < (size_t(count) * width + 7) / 8) return false;
+
+        p = _unpack(p, count, width, z);
+
+        T* v = x + f;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t next = (tag & codec_linear ? 2 * prev - before : prev) + _unzigzag(z[i]);
+            before        = prev;
+            prev          = next;
+            v[i]          = _from<T>(prev);
+        }
+    }
+
+    if (used) *used = size_t(p - data);
+    return true;
+}
+//=============================================================================
+void encodeSamples(const int16_t* x, uint32_t n, std::vector<uint8_t>& out, int16_t from)
+{
+    _encode(x, n, out, from);
+}
+//=============================================================================
+void encodeValues(const float* x, uint32_t n, std::vector<uint8_t>& out, float from) { _encode(x, n, out, from); }
+//=============================================================================
+bool decodeSamples(const uint8_t* data, size_t size, int16_t* x, uint32_t n, size_t* used, int16_t from)
+{
+    return _decode(data, size, x, n, used, from);
+}
+//=============================================================================
+bool decodeValues(const uint8_t* data, size_t size, float* x, uint32_t n, size_t* used, float from)
+{
+    return _decode(data, size, x, n, used, from);
+}
+//=============================================================================
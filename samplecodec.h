@@ -0,0 +1,45 @@
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless codec for recorded sample streams: raw int16 DSO samples and
+// float MM values. Consecutive samples are highly correlated, so each value
+// is stored as its difference from a prediction (floats by their bit
+// pattern), zigzag mapped to an unsigned and bit-packed with the smallest
+// width that fits its frame. Each frame picks the prediction giving the
+// narrower width: the previous value (noise dominated traces) or the line
+// through the previous two (slopes of large, smooth signals).
+//
+// Stream layout, frames of codec_frame values (the last one shorter):
+//
+//   uint8 width (0~32) | codec_linear when predicted from the line,
+//   ceil(values * width / 8) bytes packed LSB first
+//
+// The delta chain starts from `from` (0 unless the container continues a
+// previous stream, e.g. the blocks of a trace) and runs across frames, the
+// number of values is not stored: the container knows it (e.g. from the
+// metadata).
+// Delta, zigzag and width reduction are plain loops over independent lanes
+// that the compiler vectorizes.
+
+#define codec_frame 128u
+#define codec_linear 0x80u  // frame tag flag
+
+// worst case encoded size of `n` values
+inline size_t codecBound(uint32_t n) { return (n + codec_frame - 1) / codec_frame + size_t(n) * 4; }
+
+// append the `n` values encoded to `out`
+void encodeSamples(const int16_t* x, uint32_t n, std::vector<uint8_t>& out, int16_t from = 0);
+void encodeValues(const float* x, uint32_t n, std::vector<uint8_t>& out, float from = 0.0f);
+
+// decode `n` values, false when `data` is malformed or truncated; `used`
+// receives the bytes consumed
+bool decodeSamples(const uint8_t* data, size_t size, int16_t* x, uint32_t n, size_t* used = nullptr,
+                   int16_t from = 0);
+bool decodeValues(const uint8_t* data, size_t size, float* x, uint32_t n, size_t* used = nullptr,
+                  float from = 0.0f);
+
+#endif  // SAMPLECODEC_H
@@ -0,0 +1,62 @@
+#include "scanlist.h"
+
+#include <utility>
+
+// RSSI moves by a few dB between advertisements, do not reorder for that
+#define rssi_hysteresis 4
+
+//=============================================================================
+void ScanList::clear() { m_entries.clear(); }
+//=============================================================================
+ScanChange ScanList::update(const QString& uuid, const QString& name, int rssi, bool known, int* index)
+{
+    int i = 0;
+    while (i < m_entries.size() && m_entries[i].uuid != uuid) i++;
+
+    ScanChange change = SC_Rank;
+    if (i == m_entries.size())
+    {
+        m_entries.push_back({uuid, name, rssi, rssi, known});
+    }
+    else
+    {
+        Entry& e = m_entries[i];
+        change   = e.name != name || e.rssi != rssi || e.known != known ? SC_Text : SC_None;
+        e.name   = name;
+        e.rssi   = rssi;
+
+        if (e.known == known && qAbs(e.rankRssi - rssi) < rssi_hysteresis)
+        {
+            if (index) *index = i;
+            return change;
+        }
+        e.rankRssi = rssi;
+        e.known    = known;
+    }
+
+    // only bubble the entry to its new rank, the rest is already sorted
+    int from = i;
+    while (i > 0 && _before(m_entries[i], m_entries[i - 1]))
+    {
+        std::swap(m_entries[i], m_entries[i - 1]);
+        i--;
+    }
+    while (i + 1 < m_entries.size() && _before(m_entries[i + 1], m_entries[i]))
+    {
+        std::swap(m_entries[i], m_entries[i + 1]);
+        i++;
+    }
+    if (i != from) change = SC_Rank;
+
+    if (index) *index = i;
+    return change;
+}
+//=============================================================================
+bool ScanList::isPokit(const QString& name) { return name.startsWith("pokit", Qt::CaseInsensitive); }
+//=============================================================================
+bool ScanList::_before(const Entry& a, const Entry& b)
+{
+    if (a.known != b.known) return a.known;
+    return a.rankRssi > b.rankRssi;
+}
+//=============================================================================
@@ -0,0 +1,47 @@
+#ifndef SCANLIST_H
+#define SCANLIST_H
+
+#include <QString>
+#include <QVector>
+
+// What an update changed in the picker
+enum ScanChange
+{
+    SC_None = 0,
+    SC_Text,  // only the text of the entry (RSSI, name)
+    SC_Rank,  // entry added or moved: the ranking changed
+};
+
+// Discovered devices, ranked live: previously used devices first, then by
+// decreasing RSSI. Repeated advertisements only update the entry in place;
+// the rank follows the RSSI with a hysteresis, the shown value follows it
+// exactly.
+class ScanList
+{
+   public:
+    struct Entry
+    {
+        QString uuid;
+        QString name;
+        int rssi;      // last advertised, shown
+        int rankRssi;  // the one ranked on, moves by rssi_hysteresis steps
+        bool known;
+    };
+
+    void clear();
+
+    // `index` receives the rank of the entry after the update
+    ScanChange update(const QString& uuid, const QString& name, int rssi, bool known, int* index = nullptr);
+
+    const QVector<Entry>& entries() const { return m_entries; }
+
+    // name based filter, the advertised services are not exposed by blewrapper
+    static bool isPokit(const QString& name);
+
+   private:
+    QVector<Entry> m_entries;  // always ranked
+
+    static bool _before(const Entry& a, const Entry& b);
+};
+
+#endif  // SCANLIST_H
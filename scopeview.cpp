@@ -0,0 +1,98 @@
+#include "scopeview.h"
+
+#include <ultragui/ugoscilloscope.h>
+
+#include <QGuiApplication>
+#include <QScreen>
+
+#include <cmath>
+
+#define default_refresh_hz 60.0
+
+//=============================================================================
+ScopeView::ScopeView(QObject* parent)
+    : QObject(parent),
+      m_scope(nullptr),
+      m_scale{},
+      m_scaleValid(false),
+      m_rescale(false),
+      m_clear(false),
+      m_stats{}
+{
+    m_frame.setSingleShot(true);
+    m_frame.setTimerType(Qt::PreciseTimer);
+    connect(&m_frame, SIGNAL(timeout()), this, SLOT(_onFrame()));
+}
+//=============================================================================
+void ScopeView::attach(gui::UGOscilloscope* scope)
+{
+    m_scope      = scope;
+    m_scaleValid = false;
+
+    QScreen* screen = QGuiApplication::primaryScreen();
+    double hz       = screen && screen->refreshRate() > 1.0 ? screen->refreshRate() : default_refresh_hz;
+    m_frame.setInterval((int)std::lround(1000.0 / hz));
+}
+//=============================================================================
+void ScopeView::setup(float hdiv, uint32_t hn, float samplesize, float vdiv, uint32_t vn)
+{
+    Scale s{hdiv, hn, samplesize, vdiv, vn};
+
+    clear();
+
+    if (m_scaleValid && s == m_scale)
+    {
+        m_stats.rescalesSkipped++;
+        return;
+    }
+
+    m_scale      = s;
+    m_scaleValid = true;
+    m_rescale    = true;
+}
+//=============================================================================
+void ScopeView::clear()
+{
+    // whatever was queued for the old trace is never shown
+    m_pending.clear();
+    m_clear = true;
+    _schedule();
+}
+//=============================================================================
+void ScopeView::addBlock(const float* x, uint32_t n)
+{
+    m_stats.blocks++;
+    m_pending.insert(m_pending.end(), x, x + n);
+    _schedule();
+}
+//=============================================================================
+void ScopeView::flush()
+{
+    m_frame.stop();
+    _onFrame();
+}
+//=============================================================================
+void ScopeView::_schedule()
+{
+    if (!m_frame.isActive()) m_frame.start();
+}
+//=============================================================================
+void ScopeView::_onFrame()
+{
+    if (!m_scope || (!m_clear && !m_rescale && m_pending.empty())) return;
+
+    if (m_clear) m_scope->clear();
+    if (m_rescale)
+    {
+        m_scope->setHorizontalScale(m_scale.hdiv, m_scale.hn, m_scale.samplesize);
+        m_scope->setVerticalScale(m_scale.vdiv, m_scale.vn);
+        m_stats.rescales++;
+    }
+    if (!m_pending.empty()) m_scope->addBlock(m_pending.data(), (uint32_t)m_pending.size());
+
+    m_clear   = false;
+    m_rescale = false;
+    m_pending.clear();
+    m_stats.frames++;
+}
+//=============================================================================
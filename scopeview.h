@@ -0,0 +1,83 @@
+#ifndef SCOPEVIEW_H
+#define SCOPEVIEW_H
+
+#include <QObject>
+#include <QTimer>
+
+#include <cstdint>
+#include <vector>
+
+namespace gui
+{
+class UGOscilloscope;
+}
+
+// Counters of one ScopeView (GUI thread only)
+struct ScopeViewStats
+{
+    uint64_t blocks;           // addBlock calls received
+    uint64_t frames;           // widget updates actually performed
+    uint64_t rescales;         // grid rebuilds (scale changes)
+    uint64_t rescalesSkipped;  // setups with the scale already on screen
+};
+
+// Front end of a UGOscilloscope. Every widget call repaints the whole
+// widget, grid included, so:
+//
+// - the scale is set only when it differs from the one on screen, a new
+//   capture with the same metadata only clears the trace;
+// - clear and blocks are queued and handed to the widget once per display
+//   frame, as a single addBlock, whatever the notification rate.
+class ScopeView : public QObject
+{
+    Q_OBJECT
+
+   public:
+    ScopeView(QObject* parent = nullptr);
+
+    // frame period from the refresh rate of the primary screen
+    void attach(gui::UGOscilloscope* scope);
+
+    // new trace with the given scale
+    void setup(float hdiv, uint32_t hn, float samplesize, float vdiv, uint32_t vn);
+    void clear();
+    void addBlock(const float* x, uint32_t n);
+
+    // hands what is queued to the widget now, without waiting for the frame
+    void flush();
+
+    const ScopeViewStats& stats() const { return m_stats; }
+
+   private:
+    struct Scale
+    {
+        float hdiv;
+        uint32_t hn;
+        float samplesize;
+        float vdiv;
+        uint32_t vn;
+
+        bool operator==(const Scale& o) const
+        {
+            return hdiv == o.hdiv && hn == o.hn && samplesize == o.samplesize && vdiv == o.vdiv && vn == o.vn;
+        }
+    };
+
+    gui::UGOscilloscope* m_scope;
+    QTimer m_frame;  // single shot, armed by the first change of a frame
+
+    Scale m_scale;  // on screen, or queued when m_rescale
+    bool m_scaleValid;
+    bool m_rescale;
+    bool m_clear;
+    std::vector<float> m_pending;
+
+    ScopeViewStats m_stats;
+
+    void _schedule();
+
+   private slots:
+    void _onFrame();
+};
+
+#endif  // SCOPEVIEW_H
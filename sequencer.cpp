@@ -0,0 +1,378 @@
+#include "sequencer.h"
+
+#include "ranges.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <strings.h>
+
+#define seq_mm_interval_ms 200u  // mm default update interval
+#define seq_timeout_ms 5000u     // readout timeout, on top of the expected duration
+
+//=============================================================================
+static bool _mode(const ModeDesc* modes, uint8_t count, const std::string& name, uint8_t& out)
+{
+    for (uint8_t m = 1; m < count; m++)  // 0 is idle
+        if (strcasecmp(modes[m].shortName, name.c_str()) == 0)
+        {
+            out = m;
+            return true;
+        }
+    return false;
+}
+//=============================================================================
+static bool _range(const ModeDesc& mode, const std::string& text, uint8_t& out)
+{
+    if (strcasecmp(text.c_str(), "auto") == 0 && mode.autorange)
+    {
+        out = range_auto;
+        return true;
+    }
+
+    for (uint8_t r = 0; r < mode.rangeCount; r++)
+        if (strcasecmp(mode.ranges[r].label, text.c_str()) == 0 || text == std::to_string(r))
+        {
+            out = r;
+            return true;
+        }
+    return false;
+}
+//=============================================================================
+bool Sequencer::parse(const std::string& text, SeqStep& step, std::string* error)
+{
+    std::istringstream in(text.substr(0, text.find('#')));
+    std::string word;
+
+    auto fail = [&](const std::string& e) {
+        if (error) *error = e;
+        return false;
+    };
+
+    if (!(in >> word)) return fail("empty step");
+
+    step       = {};
+    step.count = 1;
+
+    if (word == "mm")
+    {
+        std::string mode;
+        uint8_t m;
+        if (!(in >> mode) || !_mode(mmModes, mmModeCount, mode, m)) return fail("unknown mm mode '" + mode + "'");
+
+        step.kind              = SQ_MM;
+        step.mm.mode           = (MultimeterMode)m;
+        step.mm.range          = mmModes[m].autorange ? range_auto : 0;
+        step.mm.updateInterval = seq_mm_interval_ms;
+
+        while (in >> word)
+        {
+            std::string v;
+            if (!(in >> v)) return fail("missing value for '" + word + "'");
+
+            if (word == "range")
+            {
+                if (!_range(mmModes[m], v, step.mm.range)) return fail("no range '" + v + "' in " + mode);
+            }
+            else if (word == "every")
+                step.mm.updateInterval = (uint32_t)std::max(1l, strtol(v.c_str(), nullptr, 10));
+            else
+                return fail("unknown mm option '" + word + "'");
+        }
+        return true;
+    }
+
+    if (word == "dso")
+    {
+        std::string mode;
+        uint8_t m;
+        if (!(in >> mode) || !_mode(dsoModes, dsoModeCount, mode, m)) return fail("unknown dso mode '" + mode + "'");
+
+        step.kind        = SQ_DSO;
+        step.dso.command = DSOC_FreeRunning;
+        step.dso.mode    = (DSOOpMode)m;
+        step.dso.range   = 0;
+        step.dso.window  = 100000;
+        step.dso.samples = 1000;
+
+        while (in >> word)
+        {
+            std::string v;
+            if (!(in >> v)) return fail("missing value for '" + word + "'");
+
+            if (word == "range")
+            {
+                if (!_range(dsoModes[m], v, step.dso.range)) return fail("no range '" + v + "' in " + mode);
+            }
+            else if (word == "window")
+                step.dso.window = (uint32_t)std::max(1l, strtol(v.c_str(), nullptr, 10));
+            else if (word == "samples")
+                step.dso.samples = (uint16_t)std::min(8192l, std::max(1l, strtol(v.c_str(), nullptr, 10)));
+            else if (word == "trigger")
+            {
+                std::string edge;
+                step.dso.trigger = strtof(v.c_str(), nullptr);
+                if (!(in >> edge) || (edge != "rising" && edge != "falling")) return fail("trigger needs rising|falling");
+                step.dso.command = edge == "rising" ? DSOC_RisingEdge : DSOC_FallingEdge;
+            }
+            else
+                return fail("unknown dso option '" + word + "'");
+        }
+        return true;
+    }
+
+    if (word == "read" || word == "capture" || word == "wait")
+    {
+        long n = word == "capture" ? 1 : 0;
+        in >> n;
+        if (n < 1) return fail(word + " needs a positive count");
+
+        step.kind  = word == "read" ? SQ_Read : word == "capture" ? SQ_Capture : SQ_Wait;
+        step.count = (uint32_t)n;
+        return true;
+    }
+
+    if (word == "idle")
+    {
+        step.kind = SQ_Idle;
+        return true;
+    }
+
+    return fail("unknown step '" + word + "'");
+}
+//=============================================================================
+Sequencer::Sequencer(TimerWheel* wheel)
+    : m_wheel(wheel), m_started(false), m_mm{}, m_dso{}, m_dsoArmed(false), m_done(0), m_first(0.0), m_last(0.0)
+{
+    m_timer = m_wheel->add([this]() { _onTimer(); });
+}
+//=============================================================================
+bool Sequencer::queue(int client, uint32_t line, const std::string& text)
+{
+    SeqStep step;
+    std::string error;
+
+    if (m_failed.count(client))
+    {
+        _reply(client, "error " + std::to_string(line) + " plan dropped after an error, abort to start over");
+        return false;
+    }
+
+    if (!parse(text, step, &error))
+    {
+        // the steps queued before it belong to the same plan
+        _reply(client, "error " + std::to_string(line) + " " + error);
+        m_failed.insert(client);
+        _drop(client);
+        return false;
+    }
+
+    step.client = client;
+    step.line   = line;
+    m_steps.push_back(step);
+
+    if (m_steps.size() == 1) _advance();
+    return true;
+}
+//=============================================================================
+void Sequencer::abort(int client)
+{
+    if (client < 0)
+        m_failed.clear();
+    else
+        m_failed.erase(client);
+
+    _drop(client);
+}
+//=============================================================================
+void Sequencer::_drop(int client)
+{
+    if (m_steps.empty()) return;
+
+    bool front = client < 0 || m_steps.front().client == client;
+    m_steps.erase(std::remove_if(m_steps.begin() + (front ? 0 : 1), m_steps.end(),
+                                 [client](const SeqStep& s) { return client < 0 || s.client == client; }),
+                  m_steps.end());
+
+    if (!front) return;
+
+    m_wheel->stop(m_timer);
+    m_started = false;
+    _advance();
+}
+//=============================================================================
+// runs the settings steps up to the next step that has to wait for something
+void Sequencer::_advance()
+{
+    while (!m_steps.empty())
+    {
+        SeqStep& s = m_steps.front();
+        if (m_started) return;
+
+        switch (s.kind)
+        {
+            case SQ_MM:
+                m_mm = s.mm;
+                if (m_mmWriter) m_mmWriter(m_mm);
+                break;
+
+            case SQ_DSO:
+                m_dso      = s.dso;
+                m_dsoArmed = true;
+                if (m_dsoWriter) m_dsoWriter(m_dso);
+                break;
+
+            case SQ_Idle:
+                m_mm.mode  = MM_IDLE;
+                m_dso.mode = DOM_Idle;
+                m_dsoArmed = false;
+                if (m_mmWriter) m_mmWriter(m_mm);
+                if (m_dsoWriter) m_dsoWriter(m_dso);
+                break;
+
+            case SQ_Wait:
+                m_started = true;
+                m_wheel->start(m_timer, s.count);
+                return;
+
+            case SQ_Read:
+            case SQ_Capture:
+            {
+                if (s.kind == SQ_Read ? m_mm.mode == MM_IDLE : m_dso.mode == DOM_Idle)
+                {
+                    _fail(s.kind == SQ_Read ? "no mm settings to read with" : "no dso settings to capture with");
+                    continue;
+                }
+
+                m_started = true;
+                m_done    = 0;
+                m_values.clear();
+                if (s.kind == SQ_Read) m_values.reserve(s.count);
+
+                // single shot acquisition: every capture needs its own write
+                if (s.kind == SQ_Capture && !m_dsoArmed)
+                {
+                    m_dsoArmed = true;
+                    if (m_dsoWriter) m_dsoWriter(m_dso);
+                }
+
+                uint64_t unit = s.kind == SQ_Read ? 2ull * m_mm.updateInterval : m_dso.window / 500 + seq_timeout_ms;
+                m_wheel->start(m_timer, (uint32_t)std::min<uint64_t>(seq_timeout_ms + unit * s.count, UINT32_MAX));
+                return;
+            }
+        }
+
+        _pop();
+    }
+}
+//=============================================================================
+void Sequencer::_pop()
+{
+    int client = m_steps.front().client;
+    m_steps.pop_front();
+
+    if (std::none_of(m_steps.begin(), m_steps.end(), [client](const SeqStep& x) { return x.client == client; }))
+        _reply(client, "done");
+}
+//=============================================================================
+// the front step is over, straight to the next settings
+void Sequencer::_finish()
+{
+    m_wheel->stop(m_timer);
+    m_started = false;
+    _pop();
+    _advance();
+}
+//=============================================================================
+void Sequencer::_fail(const std::string& message)
+{
+    const SeqStep& s = m_steps.front();
+    int client       = s.client;
+
+    _reply(client, "error " + std::to_string(s.line) + " " + message);
+    m_failed.insert(client);
+
+    m_wheel->stop(m_timer);
+    m_started = false;
+    m_steps.erase(std::remove_if(m_steps.begin(), m_steps.end(),
+                                 [client](const SeqStep& x) { return x.client == client; }),
+                  m_steps.end());
+}
+//=============================================================================
+void Sequencer::_onTimer()
+{
+    if (m_steps.empty() || !m_started) return;
+
+    if (m_steps.front().kind == SQ_Wait)
+    {
+        _finish();
+        return;
+    }
+
+    _fail("timeout after " + std::to_string(m_done) + " of " + std::to_string(m_steps.front().count));
+    _advance();
+}
+//=============================================================================
+void Sequencer::mmReading(const MMReading& reading, double t)
+{
+    if (m_steps.empty() || !m_started || m_steps.front().kind != SQ_Read) return;
+
+    // taken before the settings of this step were applied
+    if (reading.mode != m_mm.mode) return;
+    if (m_mm.range != range_auto && reading.range != m_mm.range) return;
+
+    if (m_values.empty()) m_first = t;
+    m_last = t;
+
+    m_values.push_back(reading.value);
+    if (++m_done < m_steps.front().count) return;
+
+    const SeqStep& s = m_steps.front();
+    auto mm          = std::minmax_element(m_values.begin(), m_values.end());
+    double sum       = 0.0;
+    for (float v : m_values) sum += v;
+
+    std::ostringstream out;
+    out.precision(7);
+    out << "read " << s.line << " " << m_values.size() << " mean " << sum / m_values.size() << " min " << *mm.first
+        << " max " << *mm.second << std::fixed << std::setprecision(6) << " from " << m_first << " to " << m_last
+        << std::defaultfloat << std::setprecision(7) << ":";
+    for (float v : m_values) out << " " << v;
+
+    _reply(s.client, out.str());
+    _finish();
+}
+//=============================================================================
+void Sequencer::dsoCapture(const CaptureBuffer& capture)
+{
+    if (m_steps.empty() || !m_started || m_steps.front().kind != SQ_Capture) return;
+
+    const DSOMetadata& md = capture.metadata();
+    if (md.mode != m_dso.mode || md.range != m_dso.range) return;
+
+    m_dsoArmed    = false;
+    uint32_t done = ++m_done;
+
+    const SeqStep& s = m_steps.front();
+    if (done < s.count)
+    {
+        m_dsoArmed = true;
+        if (m_dsoWriter) m_dsoWriter(m_dso);  // next capture first, then the reply
+    }
+
+    WindowStats st = capture.window(0, capture.size());
+
+    std::ostringstream out;
+    out.precision(7);
+    out << "capture " << s.line << " " << done << "/" << s.count << " " << st.count << " samples mean " << st.mean
+        << " rms " << st.rms << std::fixed << std::setprecision(6) << " at " << capture.start();
+
+    _reply(s.client, out.str());
+    if (done == s.count) _finish();
+}
+//=============================================================================
+void Sequencer::_reply(int client, const std::string& line)
+{
+    if (m_reply) m_reply(client, line);
+}
+//=============================================================================
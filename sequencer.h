@@ -0,0 +1,126 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include "capture.h"
+#include "protocol.h"
+#include "timerwheel.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+// Measurement plan steps, one per line ('#' comments):
+//
+//   mm <mode> [range <index|label|auto>] [every <ms>]
+//   read <n>                      n MM readings in the last mm settings
+//   dso <mode> [range <index|label>] [window <us>] [samples <n>]
+//       [trigger <level> rising|falling]
+//   capture [<n>]                 n DSO captures in the last dso settings
+//   wait <ms>
+//   idle                          MM and DSO off
+//
+// Modes are the short names of ranges.h (VDC, ADC, Res...).
+enum SeqStepKind : uint8_t
+{
+    SQ_MM = 0,
+    SQ_Read,
+    SQ_DSO,
+    SQ_Capture,
+    SQ_Wait,
+    SQ_Idle,
+};
+
+struct SeqStep
+{
+    SeqStepKind kind;
+    int client;
+    uint32_t line;
+    MMSettings mm;
+    DSOSettings dso;
+    uint32_t count;  // readings, captures or ms
+};
+
+// Runs the plans queued by the automation clients through the same
+// MMSettings / DSOSettings writes as the GUI. Steps are pipelined: settings
+// steps are written as soon as the previous readout is satisfied, from the
+// notification that completes it, without waiting for the write ack. The
+// readings still in flight under the old settings are told apart by the
+// mode and range they carry, so the write latency overlaps the end of the
+// readout instead of adding to every step.
+//
+// Replies, one line each, to the client that queued the step:
+//
+//   read <line> <n> mean <x> min <x> max <x> from <t> to <t>: <values>
+//   capture <line> <i>/<n> <samples> samples mean <x> rms <x> at <t>
+//   error <line> <message>       the rest of that client's plan is dropped
+//   done                         the client has nothing left queued
+//
+// with the corrected times (sampleclock.h) of the first and last reading
+// and of the first sample of the capture, in steady clock seconds. After an
+// error, invalid line or failed step, the lines the client sends are
+// rejected until it sends abort (or reconnects).
+class Sequencer
+{
+   public:
+    typedef std::function<void(const MMSettings&)> MMWriter;
+    typedef std::function<void(const DSOSettings&)> DSOWriter;
+    typedef std::function<void(int client, const std::string& line)> Reply;
+
+    Sequencer(TimerWheel* wheel);
+
+    void setWriters(MMWriter mm, DSOWriter dso)
+    {
+        m_mmWriter  = mm;
+        m_dsoWriter = dso;
+    }
+    void setReply(Reply reply) { m_reply = reply; }
+
+    static bool parse(const std::string& text, SeqStep& step, std::string* error = nullptr);
+
+    // parses and queues a plan line, false (and an error reply) when invalid
+    // or when the plan of `client` failed
+    bool queue(int client, uint32_t line, const std::string& text);
+
+    // drops the steps of `client`, of every client when < 0, and accepts
+    // their lines again
+    void abort(int client = -1);
+
+    bool busy() const { return !m_steps.empty(); }
+    size_t pending() const { return m_steps.size(); }
+
+    void mmReading(const MMReading& reading, double t = 0.0);
+    void dsoCapture(const CaptureBuffer& capture);  // complete captures only
+
+   private:
+    TimerWheel* m_wheel;
+    int m_timer;  // wait steps and readout timeouts
+    MMWriter m_mmWriter;
+    DSOWriter m_dsoWriter;
+    Reply m_reply;
+
+    std::deque<SeqStep> m_steps;  // front: the step in progress
+    bool m_started;               // of the front step
+
+    MMSettings m_mm;  // last written
+    DSOSettings m_dso;
+    bool m_dsoArmed;  // m_dso written and no capture taken with it yet
+
+    std::set<int> m_failed;  // clients whose plan failed, until they abort
+
+    uint32_t m_done;  // readings or captures of the front step
+    std::vector<float> m_values;
+    double m_first, m_last;  // reading times
+
+    void _drop(int client);
+    void _advance();
+    void _pop();
+    void _finish();
+    void _fail(const std::string& message);
+    void _onTimer();
+    void _reply(int client, const std::string& line);
+};
+
+#endif  // SEQUENCER_H
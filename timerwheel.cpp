@@ -0,0 +1,123 @@
+#include "timerwheel.h"
+
+#define wheel_slots 256  // power of two
+
+//=============================================================================
+TimerWheel::TimerWheel(uint32_t resolutionMs, QObject* parent)
+    : QObject(parent), m_resolution(resolutionMs), m_slots(wheel_slots), m_tick(0), m_armed(0), m_timer(this)
+{
+    m_timer.setTimerType(Qt::CoarseTimer);
+    m_timer.setInterval(m_resolution);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(_onTick()));
+    m_clock.start();
+}
+//=============================================================================
+int TimerWheel::add(Callback callback)
+{
+    m_entries.push_back({callback, false, 0, 0, 0, 0, 0});
+    return (int)m_entries.size() - 1;
+}
+//=============================================================================
+uint32_t TimerWheel::_toTicks(uint32_t ms) const
+{
+    uint32_t t = (ms + m_resolution - 1) / m_resolution;
+    return t ? t : 1;
+}
+//=============================================================================
+void TimerWheel::start(int id, uint32_t ms, bool periodic)
+{
+    Entry& e     = m_entries[id];
+    e.period     = periodic ? _toTicks(ms) : 0;
+    e.watchTicks = 0;
+    _arm(id, _toTicks(ms));
+}
+//=============================================================================
+void TimerWheel::stop(int id)
+{
+    Entry& e = m_entries[id];
+    if (!e.active) return;
+
+    e.active = false;
+    e.generation++;
+    m_armed--;
+}
+//=============================================================================
+void TimerWheel::_watch(int id, uint32_t timeoutMs)
+{
+    Entry& e     = m_entries[id];
+    e.period     = 0;
+    e.watchTicks = _toTicks(timeoutMs);
+    _arm(id, e.watchTicks);
+}
+//=============================================================================
+void TimerWheel::_arm(int id, uint64_t ticks)
+{
+    // the wheel sleeps while nothing is armed, resync its tick count first
+    if (!m_timer.isActive())
+    {
+        m_tick = m_clock.elapsed() / m_resolution;
+        m_timer.start();
+    }
+
+    Entry& e = m_entries[id];
+    if (!e.active) m_armed++;
+
+    e.active   = true;
+    e.deadline = m_tick + ticks;
+    e.generation++;
+
+    m_slots[e.deadline & (wheel_slots - 1)].push_back({id, e.generation});
+}
+//=============================================================================
+void TimerWheel::_onTick()
+{
+    uint64_t now = m_clock.elapsed() / m_resolution;
+
+    // catch up on ticks missed while the event loop was busy
+    while (m_tick < now)
+    {
+        m_tick++;
+        std::vector<SlotItem>& slot = m_slots[m_tick & (wheel_slots - 1)];
+
+        // callbacks may arm timers landing in this very slot: work on a copy
+        std::vector<SlotItem> items;
+        items.swap(slot);
+
+        for (const SlotItem& it : items)
+        {
+            Entry& e = m_entries[it.id];
+            if (!e.active || e.generation != it.generation) continue;
+
+            if (e.deadline > m_tick)  // more than one wheel turn away
+            {
+                slot.push_back(it);
+                continue;
+            }
+
+            if (e.watchTicks && e.lastTouch + e.watchTicks > m_tick)
+            {
+                // touched since it was armed: push the deadline forward
+                e.deadline = e.lastTouch + e.watchTicks;
+                m_slots[e.deadline & (wheel_slots - 1)].push_back(it);
+                continue;
+            }
+
+            if (e.period)
+            {
+                // after a stall fire once, not once per missed period
+                e.deadline = (now > m_tick ? now : m_tick) + e.period;
+                m_slots[e.deadline & (wheel_slots - 1)].push_back(it);
+            }
+            else
+            {
+                e.active = false;
+                m_armed--;
+            }
+
+            e.callback();
+        }
+    }
+
+    if (!m_armed) m_timer.stop();
+}
+//=============================================================================
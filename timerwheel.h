@@ -0,0 +1,79 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Hashed timer wheel driven by a single coarse QTimer. It serves every
+// timeout of the application (liveness, rx activity, scan, reconnect
+// backoff...) whatever the number of devices, at `resolution` granularity.
+//
+// Liveness timers are not re-armed on every packet: touch() only stores the
+// current tick, and when the deadline slot comes up the entry is pushed
+// forward by the time it was touched since.
+class TimerWheel : public QObject
+{
+    Q_OBJECT
+
+   public:
+    typedef std::function<void()> Callback;
+
+    TimerWheel(uint32_t resolutionMs, QObject* parent = nullptr);
+
+    // registers a timer, returns its id (never released, ids are cheap)
+    int add(Callback callback);
+
+    void start(int id, uint32_t ms, bool periodic = false);
+    void stop(int id);
+    bool isActive(int id) const { return m_entries[id].active; }
+
+    // liveness: `id` fires when not touched for `timeoutMs`
+    void touch(int id, uint32_t timeoutMs)
+    {
+        Entry& e = m_entries[id];
+        if (!e.active || e.watchTicks == 0) _watch(id, timeoutMs);
+        e.lastTouch = m_tick;
+    }
+
+    uint32_t resolution() const { return m_resolution; }
+
+   private:
+    struct Entry
+    {
+        Callback callback;
+        bool active;
+        uint32_t generation;  // bumped on every (re)arm, stale slot items are skipped
+        uint64_t deadline;    // in ticks
+        uint32_t period;      // in ticks, 0 = single shot
+        uint32_t watchTicks;  // liveness timeout, 0 = plain timer
+        uint64_t lastTouch;
+    };
+
+    struct SlotItem
+    {
+        int id;
+        uint32_t generation;
+    };
+
+    uint32_t m_resolution;
+    std::deque<Entry> m_entries;  // stable references, callbacks may add timers
+    std::vector<std::vector<SlotItem>> m_slots;
+    uint64_t m_tick;  // last processed tick
+    uint32_t m_armed;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+
+    void _arm(int id, uint64_t ticks);
+    void _watch(int id, uint32_t timeoutMs);
+    uint32_t _toTicks(uint32_t ms) const;
+
+   private slots:
+    void _onTick();
+};
+
+#endif  // TIMERWHEEL_H
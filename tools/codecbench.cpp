@@ -0,0 +1,223 @@
+// Compression ratio and speed of the sample codec on recorded traces
+// (GOKIT_TRACE=<file>), per DSO and MM mode and range.
+//
+//   gokit-codecbench <trace file>...
+//
+// DSO readings are encoded a capture at a time (the blocks following a
+// DSOMetadata), MM readings as one stream of values per mode and range.
+// Every stream is checked to decode back bit exact.
+
+#include "../protocol.h"
+#include "../ranges.h"
+#include "../samplecodec.h"
+#include "../tracelog.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#define bench_min_seconds 0.2  // of encoding / decoding per stream, for stable figures
+
+struct Stream
+{
+    bool dso;
+    uint8_t mode, range;
+
+    std::vector<std::vector<int16_t>> captures;  // dso
+    std::vector<float> values;                   // mm
+};
+
+typedef std::map<uint32_t, Stream> Streams;
+
+//=============================================================================
+static Stream& _stream(Streams& streams, bool dso, uint8_t mode, uint8_t range)
+{
+    Stream& s = streams[(dso << 16) | (mode << 8) | range];
+    s.dso     = dso;
+    s.mode    = mode;
+    s.range   = range;
+    return s;
+}
+//=============================================================================
+static bool _load(const char* path, Streams& streams)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        return false;
+    }
+
+    TraceFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, trace_magic, 4) != 0 || !h.version ||
+        h.version > trace_version)
+    {
+        fprintf(stderr, "%s: not a gokit v1-%u trace\n", path, trace_version);
+        fclose(f);
+        return false;
+    }
+
+    std::vector<uint8_t> payload, raw;
+    std::vector<int16_t>* capture = nullptr;
+    TraceUnpacker unpacker;
+    TraceRecord r;
+
+    while (fread(&r, sizeof(r), 1, f) == 1)
+    {
+        payload.resize(r.size);
+        if (r.size && fread(payload.data(), 1, r.size, f) != r.size) break;
+
+        if (r.type == TR_Packed)
+        {
+            if (!unpacker.unpack(payload.data(), r.size, raw)) break;
+            payload.swap(raw);
+            r.type = TR_Value;
+            r.size = (uint16_t)payload.size();
+        }
+        if (r.type != TR_Value) continue;
+
+        if (r.ch == PC_DSOMetadata)
+        {
+            DSOMetadata m;
+            if (!decodeDSOMetadata(payload.data(), r.size, m)) continue;
+
+            Stream& s = _stream(streams, true, m.mode, m.range);
+            s.captures.emplace_back();
+            s.captures.back().reserve(m.samples);
+            capture = &s.captures.back();
+        }
+        else if (r.ch == PC_DSOReading && capture)
+        {
+            DSOReading d;
+            uint32_t n;
+            if (decodeDSOReading(payload.data(), r.size, d, n)) capture->insert(capture->end(), d.data, d.data + n);
+        }
+        else if (r.ch == PC_MMReading)
+        {
+            MMReading m;
+            if (decodeMMReading(payload.data(), r.size, m)) _stream(streams, false, m.mode, m.range).values.push_back(m.value);
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+//=============================================================================
+static double _now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+//=============================================================================
+// runs `fn` until bench_min_seconds have passed, returns the seconds per run
+template <typename F>
+static double _time(F fn)
+{
+    uint32_t runs = 0;
+    double start = _now(), t;
+
+    do
+    {
+        fn();
+        runs++;
+    } while ((t = _now() - start) < bench_min_seconds);
+
+    return t / runs;
+}
+//=============================================================================
+static bool _bench(const Stream& s)
+{
+    std::vector<uint8_t> packed;
+    size_t raw = 0, samples = 0;
+    bool exact = true;
+
+    // encoded once for the ratio and the round trip check
+    if (s.dso)
+    {
+        for (const std::vector<int16_t>& c : s.captures)
+        {
+            std::vector<uint8_t> one;
+            encodeSamples(c.data(), (uint32_t)c.size(), one);
+
+            std::vector<int16_t> back(c.size());
+            exact &= decodeSamples(one.data(), one.size(), back.data(), (uint32_t)back.size()) && back == c;
+
+            packed.insert(packed.end(), one.begin(), one.end());
+            samples += c.size();
+        }
+        raw = samples * sizeof(int16_t);
+    }
+    else
+    {
+        encodeValues(s.values.data(), (uint32_t)s.values.size(), packed);
+
+        std::vector<float> back(s.values.size());
+        exact = decodeValues(packed.data(), packed.size(), back.data(), (uint32_t)back.size()) &&
+                memcmp(back.data(), s.values.data(), back.size() * sizeof(float)) == 0;
+
+        samples = s.values.size();
+        raw     = samples * sizeof(float);
+    }
+
+    if (!samples) return true;
+
+    std::vector<uint8_t> scratch;
+    scratch.reserve(packed.size() + codecBound((uint32_t)samples));
+    std::vector<int16_t> outSamples(s.dso ? samples : 0);
+    std::vector<float> outValues(s.dso ? 0 : samples);
+
+    double enc = _time([&]() {
+        scratch.clear();
+        if (!s.dso) encodeValues(s.values.data(), (uint32_t)samples, scratch);
+        else
+            for (const std::vector<int16_t>& c : s.captures) encodeSamples(c.data(), (uint32_t)c.size(), scratch);
+    });
+
+    double dec = _time([&]() {
+        if (!s.dso)
+        {
+            decodeValues(packed.data(), packed.size(), outValues.data(), (uint32_t)samples);
+            return;
+        }
+
+        const uint8_t* p = packed.data();
+        size_t left = packed.size(), at = 0, used = 0;
+        for (const std::vector<int16_t>& c : s.captures)
+        {
+            decodeSamples(p, left, outSamples.data() + at, (uint32_t)c.size(), &used);
+            p += used;
+            left -= used;
+            at += c.size();
+        }
+    });
+
+    const ModeDesc& m = s.dso ? dsoMode((DSOOpMode)s.mode) : mmMode((MultimeterMode)s.mode);
+    printf("%-3s %-6s %-10s %10zu %10.1f %10.1f %7.2fx %9.0f %9.0f %s\n", s.dso ? "DSO" : "MM", m.shortName,
+           rangeLabel(m, s.range), samples, raw / 1024.0, packed.size() / 1024.0, (double)raw / packed.size(),
+           raw / enc / 1e6, raw / dec / 1e6, exact ? "" : "MISMATCH");
+
+    return exact;
+}
+//=============================================================================
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace file>...\n", argv[0]);
+        return 2;
+    }
+
+    Streams streams;
+    for (int i = 1; i < argc; i++)
+        if (!_load(argv[i], streams)) return 1;
+
+    printf("%-3s %-6s %-10s %10s %10s %10s %8s %9s %9s\n", "", "mode", "range", "samples", "raw KB", "packed KB",
+           "ratio", "enc MB/s", "dec MB/s");
+
+    bool ok = true;
+    for (const auto& s : streams) ok &= _bench(s.second);
+
+    return ok ? 0 : 1;
+}
+//=============================================================================
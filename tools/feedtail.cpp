@@ -0,0 +1,122 @@
+// Follows the gokit live data feed (GOKIT_FEED=<name>) and prints its
+// records, a reference consumer of the layout documented in livefeed.h.
+//
+//   gokit-feedtail <name> [-s]
+//
+// -s prints a summary line per second instead of every record.
+
+#include "../livefeed.h"
+#include "../protocol.h"
+#include "../ranges.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#define feedtail_poll_ms 1  // reader side only, the writer never waits for us
+
+//=============================================================================
+static void _print(const FeedSlot& s, const std::vector<uint8_t>& p)
+{
+    printf("%14.6f ms  ", s.ns / 1e6);
+
+    switch (s.type)
+    {
+        case FR_DSOMetadata:
+        {
+            DSOMetadata d;
+            if (p.size() < sizeof(d)) break;
+            memcpy(&d, p.data(), sizeof(d));
+            const ModeDesc& m = dsoMode(d.mode);
+            printf("metadata  %s, range %s, window %uus, %u samples @ %uHz\n", m.name, rangeLabel(m, d.range),
+                   d.window, d.samples, d.samplingRate);
+            return;
+        }
+        case FR_DSOBlock:
+        {
+            FeedBlock b;
+            if (p.size() < sizeof(b)) break;
+            memcpy(&b, p.data(), sizeof(b));
+            if (p.size() < sizeof(b) + b.count * sizeof(float)) break;
+
+            std::vector<float> x(b.count);
+            memcpy(x.data(), p.data() + sizeof(b), b.count * sizeof(float));
+            printf("block     %u samples from %u:", b.count, b.offset);
+            for (float v : x) printf(" %g", v);
+            printf("\n");
+            return;
+        }
+        case FR_MMReading:
+        {
+            MMReading r;
+            if (p.size() < sizeof(r)) break;
+            memcpy(&r, p.data(), sizeof(r));
+            const ModeDesc& m = mmMode(r.mode);
+            printf("reading   %g %s (%s, range %s)\n", r.value, m.unit, m.name, rangeLabel(m, r.range));
+            return;
+        }
+        default:
+            printf("type %u, %u bytes\n", s.type, s.size);
+            return;
+    }
+
+    printf("MALFORMED, type %u, %u bytes\n", s.type, s.size);
+}
+//=============================================================================
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <name> [-s]\n", argv[0]);
+        return 2;
+    }
+
+    bool summary = argc > 2 && strcmp(argv[2], "-s") == 0;
+
+    LiveFeedReader feed;
+    std::string error;
+    if (!feed.open(argv[1], &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    FeedSlot slot;
+    std::vector<uint8_t> payload;
+    uint64_t counts[3] = {}, samples = 0;
+    auto last          = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+        while (feed.next(slot, payload))
+        {
+            if (!summary)
+            {
+                _print(slot, payload);
+                continue;
+            }
+
+            if (slot.type < 3) counts[slot.type]++;
+            if (slot.type == FR_DSOBlock && payload.size() >= sizeof(FeedBlock))
+                samples += ((const FeedBlock*)payload.data())->count;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (summary && now - last >= std::chrono::seconds(1))
+        {
+            printf("%llu captures, %llu blocks (%llu samples), %llu readings, %llu lost\n",
+                   (unsigned long long)counts[FR_DSOMetadata], (unsigned long long)counts[FR_DSOBlock],
+                   (unsigned long long)samples, (unsigned long long)counts[FR_MMReading],
+                   (unsigned long long)feed.lost());
+            fflush(stdout);
+            memset(counts, 0, sizeof(counts));
+            samples = 0;
+            last    = now;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(feedtail_poll_ms));
+    }
+}
+//=============================================================================
@@ -0,0 +1,228 @@
+// Prints a gokit binary trace (GOKIT_TRACE=<file>) in human readable form.
+//
+//   gokit-tracedump <trace file> [-x]
+//
+// -x also dumps the raw payload bytes of every record.
+
+#include "../protocol.h"
+#include "../ranges.h"
+#include "../tracelog.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+//=============================================================================
+static void _hex(const uint8_t* p, uint32_t n)
+{
+    printf("   ");
+    for (uint32_t i = 0; i < n; i++) printf(" %02x", p[i]);
+    printf("\n");
+}
+//=============================================================================
+static void _value(uint8_t ch, const uint8_t* p, uint32_t n)
+{
+    switch (ch)
+    {
+        case PC_Device:
+        {
+            DeviceData d;
+            if (!decodeDeviceData(p, n, d)) break;
+            printf("fw %u.%u, max %uV %uA %uKOhm %uKHz, buffer %u, mac %02x:%02x:%02x:%02x:%02x:%02x\n", d.fwMaj,
+                   d.fwMin, d.maxVoltage, d.maxCurrent, d.maxResistance, d.maxSamplingRate, d.maxBufferSize,
+                   d.macAddr[0], d.macAddr[1], d.macAddr[2], d.macAddr[3], d.macAddr[4], d.macAddr[5]);
+            return;
+        }
+        case PC_Status:
+        {
+            DeviceStatus s;
+            if (!decodeDeviceStatus(p, n, s)) break;
+            printf("state %u, battery %.3fV, switch %u\n", s.state, s.batteryVoltage, s.modeswitch);
+            return;
+        }
+        case PC_MMSetting:
+        {
+            MMSettings s;
+            if (n < sizeof(s)) break;
+            memcpy(&s, p, sizeof(s));
+            const ModeDesc& m = mmMode(s.mode);
+            printf("%s, range %s, every %ums\n", m.name, rangeLabel(m, s.range), s.updateInterval);
+            return;
+        }
+        case PC_MMReading:
+        {
+            MMReading r;
+            if (!decodeMMReading(p, n, r)) break;
+            const ModeDesc& m = mmMode(r.mode);
+            printf("%g %s (%s, range %s, status %u)\n", r.value, m.unit, m.name, rangeLabel(m, r.range), r.status);
+            return;
+        }
+        case PC_Button:
+        {
+            DeviceButton b;
+            if (!decodeDeviceButton(p, n, b)) break;
+            printf("button %u\n", b.button);
+            return;
+        }
+        case PC_Torch:
+        {
+            uint8_t t;
+            if (!decodeTorch(p, n, t)) break;
+            printf("torch %s\n", t ? "on" : "off");
+            return;
+        }
+        case PC_DSOSetting:
+        {
+            DSOSettings s;
+            if (n < sizeof(s)) break;
+            memcpy(&s, p, sizeof(s));
+            const ModeDesc& m = dsoMode(s.mode);
+            printf("command %u, trigger %g, %s, range %s, window %uus, %u samples\n", s.command, s.trigger, m.name,
+                   rangeLabel(m, s.range), s.window, s.samples);
+            return;
+        }
+        case PC_DSOMetadata:
+        {
+            DSOMetadata d;
+            if (!decodeDSOMetadata(p, n, d)) break;
+            const ModeDesc& m = dsoMode(d.mode);
+            printf("status %u, scale %g, %s, range %s, window %uus, %u samples @ %uHz\n", d.status, d.scale, m.name,
+                   rangeLabel(m, d.range), d.window, d.samples, d.samplingRate);
+            return;
+        }
+        case PC_DSOReading:
+        {
+            DSOReading r;
+            uint32_t samples;
+            if (!decodeDSOReading(p, n, r, samples)) break;
+            printf("%u samples:", samples);
+            for (uint32_t i = 0; i < samples; i++) printf(" %d", r.data[i]);
+            printf("\n");
+            return;
+        }
+        default:
+            printf("%u bytes\n", n);
+            return;
+    }
+
+    printf("MALFORMED, %u bytes\n", n);
+}
+//=============================================================================
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace file> [-x]\n", argv[0]);
+        return 2;
+    }
+
+    bool hex = argc > 2 && strcmp(argv[2], "-x") == 0;
+
+    FILE* f = fopen(argv[1], "rb");
+    if (!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    TraceFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, trace_magic, 4) != 0)
+    {
+        fprintf(stderr, "%s: not a gokit trace\n", argv[1]);
+        return 1;
+    }
+    if (!h.version || h.version > trace_version)
+    {
+        fprintf(stderr, "%s: unsupported trace version %u\n", argv[1], h.version);
+        return 1;
+    }
+
+    printf("# gokit trace v%u, started at %llu ns (unix epoch)\n", h.version, (unsigned long long)h.startEpochNs);
+
+    static const char* types[] = {"value", "chars", "note", "write", "gap", "alarm"};
+
+    std::vector<uint8_t> payload, raw;
+    TraceUnpacker unpacker;
+    TraceRecord r;
+    uint64_t count = 0, packed = 0, unpacked = 0;
+
+    while (fread(&r, sizeof(r), 1, f) == 1)
+    {
+        payload.resize(r.size);
+        if (r.size && fread(payload.data(), 1, r.size, f) != r.size)
+        {
+            fprintf(stderr, "truncated record at #%llu\n", (unsigned long long)count);
+            break;
+        }
+        count++;
+
+        // shown as the notification it stands for
+        if (r.type == TR_Packed)
+        {
+            if (!unpacker.unpack(payload.data(), r.size, raw))
+            {
+                fprintf(stderr, "malformed packed record at #%llu\n", (unsigned long long)count);
+                break;
+            }
+            packed += r.size;
+            unpacked += raw.size();
+            payload.swap(raw);
+            r.type = TR_Value;
+            r.size = (uint16_t)payload.size();
+        }
+
+        const char* type = r.type < sizeof(types) / sizeof(types[0]) ? types[r.type] : "?";
+        printf("%14.6f ms  %-5s ", r.ns / 1e6, type);
+
+        switch (r.type)
+        {
+            case TR_Value:
+            case TR_Write:
+                printf("%-12s ", pokitCharName((PokitChar)r.ch));
+                _value(r.ch, payload.data(), r.size);
+                break;
+
+            case TR_Chars:
+                printf("%-12s", pokitServiceName((PokitService)r.ch));
+                for (uint8_t id : payload) printf(" %s", pokitCharName((PokitChar)id));
+                printf("\n");
+                break;
+
+            case TR_Note:
+                printf("%.*s\n", (int)r.size, (const char*)payload.data());
+                break;
+
+            case TR_Gap:
+            {
+                uint64_t ns = 0;
+                if (r.size == sizeof(ns)) memcpy(&ns, payload.data(), sizeof(ns));
+                printf("no data for %.3f ms, link lost\n", ns / 1e6);
+                break;
+            }
+
+            case TR_Alarm:
+            {
+                TraceAlarm a = {};
+                if (r.size >= sizeof(a)) memcpy(&a, payload.data(), sizeof(a));
+                int text = r.size > sizeof(a) ? int(r.size - sizeof(a)) : 0;
+                printf("rule %u %s at %g: %.*s\n", r.ch, a.raised ? "raised" : "cleared", a.value, text,
+                       (const char*)payload.data() + sizeof(a));
+                break;
+            }
+
+            default:
+                printf("type %u, %u bytes\n", r.type, r.size);
+                break;
+        }
+
+        if (hex && r.type != TR_Note) _hex(payload.data(), r.size);
+    }
+
+    fclose(f);
+    printf("# %llu records\n", (unsigned long long)count);
+    if (packed)
+        printf("# DSO samples packed %llu -> %llu bytes (%.2fx)\n", (unsigned long long)unpacked,
+               (unsigned long long)packed, (double)unpacked / packed);
+    return 0;
+}
+//=============================================================================
@@ -0,0 +1,205 @@
+#include "tracelog.h"
+
+#include "protocol.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+
+#define trace_ring_size (1u << 20)  // must be a power of two
+#define trace_ring_mask (trace_ring_size - 1)
+#define trace_note_max 256
+
+//=============================================================================
+static inline uint64_t _monoNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+//=============================================================================
+TraceLog::TraceLog()
+    : m_file(nullptr),
+      m_ring(nullptr),
+      m_head(0),
+      m_tail(0),
+      m_dropped(0),
+      m_recorded(0),
+      m_written(0),
+      m_running(false),
+      m_start(0),
+      m_packLast(0)
+{
+}
+//=============================================================================
+TraceLog::~TraceLog() { close(); }
+//=============================================================================
+bool TraceLog::open(const std::string& path)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file) return false;
+
+    TraceFileHeader h = {};
+    memcpy(h.magic, trace_magic, sizeof(h.magic));
+    h.version      = trace_version;
+    h.startEpochNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    fwrite(&h, sizeof(h), 1, m_file);
+
+    m_ring  = new uint8_t[trace_ring_size];
+    m_start = _monoNs();
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_recorded.store(0, std::memory_order_relaxed);
+    m_written.store(0, std::memory_order_relaxed);
+    m_packLast = 0;
+
+    m_running.store(true, std::memory_order_release);
+    m_writer = std::thread(&TraceLog::_writerLoop, this);
+
+    return true;
+}
+//=============================================================================
+void TraceLog::close()
+{
+    if (!m_file) return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_writer.joinable()) m_writer.join();
+
+    _drain();
+    fclose(m_file);
+    m_file = nullptr;
+
+    delete[] m_ring;
+    m_ring = nullptr;
+}
+//=============================================================================
+void TraceLog::record(TraceRecordType type, uint8_t ch, const void* data, uint32_t size)
+{
+    if (!m_file) return;
+    if (size > UINT16_MAX) size = UINT16_MAX;
+
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    uint64_t tail = m_tail.load(std::memory_order_acquire);
+    uint32_t need = sizeof(TraceRecord) + size;
+
+    if (trace_ring_size - (head - tail) < need)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceRecord r;
+    r.ns   = _monoNs() - m_start;
+    r.type = type;
+    r.ch   = ch;
+    r.size = (uint16_t)size;
+
+    _push(&r, sizeof(r), head);
+    if (size) _push(data, size, head + sizeof(r));
+
+    m_head.store(head + need, std::memory_order_release);
+}
+//=============================================================================
+void TraceLog::note(const char* fmt, ...)
+{
+    if (!m_file) return;
+
+    char buf[trace_note_max];
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (n < 0) return;
+    if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+
+    record(TR_Note, 0, buf, (uint32_t)n);
+}
+//=============================================================================
+void TraceLog::_push(const void* src, uint32_t size, uint64_t at)
+{
+    uint32_t off   = uint32_t(at & trace_ring_mask);
+    uint32_t first = trace_ring_size - off;
+    if (first > size) first = size;
+
+    memcpy(m_ring + off, src, first);
+    memcpy(m_ring, (const uint8_t*)src + first, size - first);
+}
+//=============================================================================
+void TraceLog::_pop(void* dst, uint32_t size, uint64_t at) const
+{
+    uint32_t off   = uint32_t(at & trace_ring_mask);
+    uint32_t first = trace_ring_size - off;
+    if (first > size) first = size;
+
+    memcpy(dst, m_ring + off, first);
+    memcpy((uint8_t*)dst + first, m_ring, size - first);
+}
+//=============================================================================
+void TraceLog::_writerLoop()
+{
+    while (m_running.load(std::memory_order_acquire))
+    {
+        _drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+//=============================================================================
+void TraceLog::_drain()
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == tail) return;
+
+    // the ring holds whole records back to back, as recorded
+    while (tail != head)
+    {
+        TraceRecord r;
+        _pop(&r, sizeof(r), tail);
+        m_payload.resize(r.size);
+        if (r.size) _pop(m_payload.data(), r.size, tail + sizeof(r));
+
+        tail += sizeof(r) + r.size;
+        m_tail.store(tail, std::memory_order_release);
+
+        _write(r);
+    }
+
+    fflush(m_file);
+}
+//=============================================================================
+void TraceLog::_write(TraceRecord r)
+{
+    const uint8_t* payload = m_payload.data();
+    m_recorded.fetch_add(sizeof(r) + r.size, std::memory_order_relaxed);
+
+    if (r.type == TR_Value && r.ch == PC_DSOReading && r.size && r.size % sizeof(int16_t) == 0)
+    {
+        uint16_t n = r.size / sizeof(int16_t);
+        m_samples.resize(n);
+        memcpy(m_samples.data(), payload, r.size);
+
+        m_packed.assign((const uint8_t*)&n, (const uint8_t*)&n + sizeof(n));
+        encodeSamples(m_samples.data(), n, m_packed, m_packLast);
+
+        if (m_packed.size() < r.size)
+        {
+            m_packLast = m_samples[n - 1];
+            r.type     = TR_Packed;
+            r.size     = (uint16_t)m_packed.size();
+            payload    = m_packed.data();
+        }
+    }
+
+    fwrite(&r, sizeof(r), 1, m_file);
+    if (r.size) fwrite(payload, 1, r.size, m_file);
+    m_written.fetch_add(sizeof(r) + r.size, std::memory_order_relaxed);
+}
+//=============================================================================
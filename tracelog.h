@@ -0,0 +1,157 @@
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include "samplecodec.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Binary trace file layout (native little endian):
+//
+//   TraceFileHeader
+//   TraceRecord + `size` payload bytes
+//   TraceRecord + `size` payload bytes
+//   ...
+//
+// TR_Value payloads are the raw notification bytes of characteristic `ch`
+// (a PokitChar), TR_Write payloads the bytes gokit wrote to `ch`, TR_Chars
+// payloads the PokitChar ids discovered in service `ch` (a PokitService),
+// TR_Gap payloads the uint64 outage length in ns (the record is stamped
+// when the link comes back), TR_Alarm payloads a TraceAlarm followed by the
+// rule text (`ch` is the rule index) and TR_Note payloads free text without
+// terminator.
+//
+// TR_Packed records are PC_DSOReading notifications (`ch`) stored with the
+// sample codec (samplecodec.h): the uint16 sample count followed by the
+// encoded samples, whose delta chain continues from the last sample of the
+// previous TR_Packed record (0 for the first one). A notification the codec
+// doesn't make smaller stays a TR_Value. Readers turn them back into the
+// TR_Value payload with a TraceUnpacker, reading the records in order.
+// Version 1 traces have no TR_Packed records.
+
+#define trace_magic "GKTR"
+#define trace_version 2
+
+enum TraceRecordType : uint8_t
+{
+    TR_Value  = 0,  // characteristic notification / read
+    TR_Chars  = 1,  // characteristics discovered, `ch` is the PokitService
+    TR_Note   = 2,  // text message
+    TR_Write  = 3,  // value written by gokit to characteristic `ch`
+    TR_Gap    = 4,  // data gap caused by a link outage
+    TR_Alarm  = 5,  // alarm rule raised or cleared
+    TR_Packed = 6,  // DSO samples notification, codec encoded
+};
+
+#pragma pack(push, 1)
+struct TraceFileHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t startEpochNs;  // wall clock of the first record timestamp (t = 0)
+};
+
+struct TraceRecord
+{
+    uint64_t ns;  // monotonic, since the trace was opened
+    TraceRecordType type;
+    uint8_t ch;
+    uint16_t size;
+};
+
+struct TraceAlarm
+{
+    uint8_t raised;  // 0: cleared
+    float value;     // that raised / cleared the alarm
+};
+#pragma pack(pop)
+
+// Decoder of the TR_Packed records of one trace
+class TraceUnpacker
+{
+   public:
+    TraceUnpacker() : m_last(0) {}
+
+    // the notification bytes of a TR_Packed payload, false when malformed
+    bool unpack(const uint8_t* data, uint32_t size, std::vector<uint8_t>& out)
+    {
+        uint16_t n;
+        if (size < sizeof(n)) return false;
+        memcpy(&n, data, sizeof(n));
+
+        std::vector<int16_t> x(n);
+        if (!decodeSamples(data + sizeof(n), size - sizeof(n), x.data(), n, nullptr, m_last)) return false;
+        if (n) m_last = x[n - 1];
+
+        out.resize(n * sizeof(int16_t));
+        memcpy(out.data(), x.data(), out.size());
+        return true;
+    }
+
+   private:
+    int16_t m_last;
+};
+
+// Asynchronous trace writer. Records are appended to a lock-free single
+// producer / single consumer byte ring and a background thread drains the
+// ring into the file, so tracing a packet costs a clock read and a memcpy.
+// All the producer methods must be called from the same thread (the GUI
+// thread, where the Central callbacks are delivered). When the ring is
+// full the record is dropped and counted, the producer never blocks. The
+// DSO sample notifications are packed (TR_Packed) by the writer thread.
+class TraceLog
+{
+   public:
+    TraceLog();
+    ~TraceLog();
+
+    TraceLog(const TraceLog&)            = delete;
+    TraceLog& operator=(const TraceLog&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_file != nullptr; }
+
+    void record(TraceRecordType type, uint8_t ch, const void* data, uint32_t size);
+    void value(uint8_t ch, const void* data, uint32_t size) { record(TR_Value, ch, data, size); }
+    void note(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // bytes recorded over bytes written to the file
+    double packRatio() const
+    {
+        uint64_t written = m_written.load(std::memory_order_relaxed);
+        return written ? double(m_recorded.load(std::memory_order_relaxed)) / written : 1.0;
+    }
+
+   private:
+    FILE* m_file;
+    uint8_t* m_ring;
+    std::atomic<uint64_t> m_head;  // written by the producer
+    std::atomic<uint64_t> m_tail;  // written by the writer thread
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_recorded, m_written;
+    std::atomic<bool> m_running;
+    std::thread m_writer;
+    uint64_t m_start;
+
+    // writer thread only
+    std::vector<uint8_t> m_payload, m_packed;
+    std::vector<int16_t> m_samples;
+    int16_t m_packLast;
+
+    void _writerLoop();
+    void _drain();
+    void _write(TraceRecord r);
+    void _push(const void* src, uint32_t size, uint64_t at);
+    void _pop(void* dst, uint32_t size, uint64_t at) const;
+};
+
+#endif  // TRACELOG_H
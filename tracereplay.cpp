@@ -0,0 +1,139 @@
+#include "tracereplay.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define replay_batch_ns 5000000  // max time spent delivering in one go, as fast as possible mode
+#define replay_max_chars 32u      // per TR_Chars record, as many as charsDiscovered records
+
+//=============================================================================
+// the file is checked as strictly as the decoders check the BLE payloads:
+// the sink indexes tables with `ch` and the characteristic ids
+static bool _valid(const TraceRecord& r, const uint8_t* payload)
+{
+    if (r.type == TR_Value) return r.ch < PC_Count;
+
+    bool ok = (r.ch < PSRV_Count) & (r.size <= replay_max_chars);
+    for (uint32_t i = 0; ok && i < r.size; i++) ok &= payload[i] < PC_Count;
+    return ok;
+}
+
+//=============================================================================
+TraceReplay::TraceReplay(TraceSink* sink, QObject* parent)
+    : QObject(parent), m_sink(sink), m_next(0), m_speed(1.0), m_timer(this)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(_onTimer()));
+}
+//=============================================================================
+bool TraceReplay::load(const std::string& path)
+{
+    stop();
+    m_events.clear();
+    m_payloads.clear();
+
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    TraceFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, trace_magic, 4) != 0 || !h.version ||
+        h.version > trace_version)
+    {
+        fclose(f);
+        return false;
+    }
+
+    TraceUnpacker unpacker;
+    std::vector<uint8_t> packed, raw;
+    TraceRecord r;
+
+    while (fread(&r, sizeof(r), 1, f) == 1)
+    {
+        size_t offset = m_payloads.size();
+        m_payloads.resize(offset + r.size);
+        if (r.size && fread(m_payloads.data() + offset, 1, r.size, f) != r.size) break;  // truncated tail
+
+        // back to the notification as the device sent it
+        if (r.type == TR_Packed)
+        {
+            packed.assign(m_payloads.begin() + offset, m_payloads.end());
+            m_payloads.resize(offset);
+            if (!unpacker.unpack(packed.data(), r.size, raw)) break;  // the chain can't go on
+
+            m_payloads.insert(m_payloads.end(), raw.begin(), raw.end());
+            r.type = TR_Value;
+            r.size = (uint16_t)raw.size();
+        }
+
+        // only what the device sent is replayed, not our own writes and notes
+        if ((r.type != TR_Value && r.type != TR_Chars) || !_valid(r, m_payloads.data() + offset))
+        {
+            m_payloads.resize(offset);
+            continue;
+        }
+
+        m_events.push_back({r.ns, r.type, r.ch, (uint32_t)offset, r.size});
+    }
+
+    fclose(f);
+    return !m_events.empty();
+}
+//=============================================================================
+void TraceReplay::start(double speed)
+{
+    if (m_events.empty()) return;
+
+    m_speed = speed < 0.0 ? 0.0 : speed;
+    m_next  = 0;
+    m_clock.start();
+    m_timer.start(0);
+}
+//=============================================================================
+void TraceReplay::stop() { m_timer.stop(); }
+//=============================================================================
+void TraceReplay::_deliver(const Event& e)
+{
+    const uint8_t* p = m_payloads.data() + e.offset;
+
+    if (e.type == TR_Value)
+        m_sink->replayValue((PokitChar)e.ch, p, e.size);
+    else
+        m_sink->replayChars((PokitService)e.ch, p, e.size);
+}
+//=============================================================================
+void TraceReplay::_onTimer()
+{
+    uint64_t base  = m_events.front().ns;
+    uint64_t batch = m_clock.nsecsElapsed();
+
+    while (m_next < m_events.size())
+    {
+        const Event& e = m_events[m_next];
+        uint64_t now   = m_clock.nsecsElapsed();
+
+        if (m_speed > 0.0)
+        {
+            uint64_t due = uint64_t(double(e.ns - base) / m_speed);
+            if (due > now)
+            {
+                // rounded up: a 0 ms timer would spin the event loop until the event is due,
+                // everything due by the time it fires goes out in the same pass
+                m_timer.start(int((due - now + 999999) / 1000000));
+                return;
+            }
+        }
+        else if (now - batch > replay_batch_ns)
+        {
+            // as fast as possible, but let the GUI repaint between batches
+            m_timer.start(0);
+            return;
+        }
+
+        _deliver(e);
+        m_next++;
+    }
+
+    m_sink->replayFinished(m_events.size(), m_clock.nsecsElapsed() / 1e9);
+}
+//=============================================================================
@@ -0,0 +1,67 @@
+#ifndef TRACEREPLAY_H
+#define TRACEREPLAY_H
+
+#include "protocol.h"
+#include "tracelog.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <string>
+#include <vector>
+
+// Receiver of the replayed events
+class TraceSink
+{
+   public:
+    virtual ~TraceSink() = default;
+
+    virtual void replayValue(PokitChar ch, const uint8_t* data, uint32_t size) = 0;
+    virtual void replayChars(PokitService service, const uint8_t* ids, uint32_t n) {}
+    virtual void replayFinished(uint64_t events, double seconds) {}
+};
+
+// Feeds the TR_Value and TR_Chars records of a trace file to a TraceSink
+// (records naming an unknown characteristic or service are skipped),
+// preserving their original spacing scaled by `speed`: 1 is real time,
+// 10 ten times faster, 0 as fast as possible (the event loop still runs
+// between batches so that the widgets repaint). Same trace, same speed,
+// same sequence of calls: a captured session becomes a repeatable benchmark.
+class TraceReplay : public QObject
+{
+    Q_OBJECT
+
+   public:
+    TraceReplay(TraceSink* sink, QObject* parent = nullptr);
+
+    bool load(const std::string& path);
+    void start(double speed);
+    void stop();
+    bool isRunning() const { return m_timer.isActive(); }
+
+   private:
+    struct Event
+    {
+        uint64_t ns;
+        TraceRecordType type;
+        uint8_t ch;
+        uint32_t offset;  // in m_payloads
+        uint16_t size;
+    };
+
+    TraceSink* m_sink;
+    std::vector<Event> m_events;
+    std::vector<uint8_t> m_payloads;
+    size_t m_next;
+    double m_speed;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+
+    void _deliver(const Event& e);
+
+   private slots:
+    void _onTimer();
+};
+
+#endif  // TRACEREPLAY_H
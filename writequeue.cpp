@@ -0,0 +1,83 @@
+#include "writequeue.h"
+
+#define write_ack_timeout_ms 1000u
+
+//=============================================================================
+WriteQueue::WriteQueue(TimerWheel* wheel)
+    : m_wheel(wheel), m_issued(0), m_coalesced(0), m_timeouts(0), m_lastSettleMs(0.0), m_maxSettleMs(0.0)
+{
+    for (int ch = 0; ch < PC_Count; ch++)
+    {
+        Slot& s    = m_slots[ch];
+        s.inFlight = false;
+        s.pending  = false;
+        s.timer    = m_wheel->add([this, ch]() { _onAckTimeout((PokitChar)ch); });
+    }
+}
+//=============================================================================
+void WriteQueue::write(PokitChar ch, const void* data, uint32_t size)
+{
+    if (ch >= PC_Count) return;
+    Slot& s = m_slots[ch];
+
+    if (!s.inFlight && !s.pending) s.burst = std::chrono::steady_clock::now();
+    if (s.pending) m_coalesced++;
+
+    const uint8_t* p = (const uint8_t*)data;
+    s.data.assign(p, p + size);
+    s.pending = true;
+
+    if (!s.inFlight) _issue(ch);
+}
+//=============================================================================
+void WriteQueue::_issue(PokitChar ch)
+{
+    Slot& s   = m_slots[ch];
+    s.pending = false;
+
+    if (!m_writer || !m_writer(ch, s.data.data(), (uint32_t)s.data.size())) return;
+
+    m_issued++;
+    s.inFlight = true;
+    m_wheel->start(s.timer, write_ack_timeout_ms);
+}
+//=============================================================================
+void WriteQueue::written(PokitChar ch)
+{
+    if (ch >= PC_Count) return;
+    Slot& s = m_slots[ch];
+
+    if (!s.inFlight) return;  // not ours, or acked after the timeout
+    s.inFlight = false;
+    m_wheel->stop(s.timer);
+
+    if (s.pending)
+    {
+        _issue(ch);
+        return;
+    }
+
+    // idle again: the device runs the last requested settings
+    auto dt        = std::chrono::steady_clock::now() - s.burst;
+    m_lastSettleMs = std::chrono::duration<double, std::milli>(dt).count();
+    if (m_lastSettleMs > m_maxSettleMs) m_maxSettleMs = m_lastSettleMs;
+}
+//=============================================================================
+void WriteQueue::_onAckTimeout(PokitChar ch)
+{
+    // a late ack will be taken for the next write's, at worst that one is
+    // considered settled a little early
+    m_timeouts++;
+    written(ch);
+}
+//=============================================================================
+void WriteQueue::reset()
+{
+    for (Slot& s : m_slots)
+    {
+        s.inFlight = false;
+        s.pending  = false;
+        m_wheel->stop(s.timer);
+    }
+}
+//=============================================================================
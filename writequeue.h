@@ -0,0 +1,63 @@
+#ifndef WRITEQUEUE_H
+#define WRITEQUEUE_H
+
+#include "protocol.h"
+#include "timerwheel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Per characteristic GATT write queue with last-writer-wins coalescing. At
+// most one write per characteristic is in flight; requests arriving in the
+// meantime replace each other, so only the newest one is written once the
+// device acknowledges (written(), from charValueWritten). A write not acked
+// within write_ack_timeout_ms is considered lost and the queue moves on.
+//
+// Settle time is measured from the first request of a burst to the ack of
+// the write that leaves the characteristic idle.
+class WriteQueue
+{
+   public:
+    // issues the GATT write, false if the characteristic is not available
+    typedef std::function<bool(PokitChar ch, const uint8_t* data, uint32_t size)> Writer;
+
+    WriteQueue(TimerWheel* wheel);
+
+    void setWriter(Writer writer) { m_writer = writer; }
+
+    void write(PokitChar ch, const void* data, uint32_t size);
+    void written(PokitChar ch);
+
+    // link lost: drops everything in flight and pending
+    void reset();
+
+    uint64_t issued() const { return m_issued; }
+    uint64_t coalesced() const { return m_coalesced; }  // requests replaced before being written
+    uint64_t timeouts() const { return m_timeouts; }
+    double lastSettleMs() const { return m_lastSettleMs; }
+    double maxSettleMs() const { return m_maxSettleMs; }
+
+   private:
+    struct Slot
+    {
+        bool inFlight;
+        bool pending;
+        std::vector<uint8_t> data;  // of the pending write
+        std::chrono::steady_clock::time_point burst;
+        int timer;  // ack timeout, on the wheel
+    };
+
+    TimerWheel* m_wheel;
+    Writer m_writer;
+    Slot m_slots[PC_Count];
+
+    uint64_t m_issued, m_coalesced, m_timeouts;
+    double m_lastSettleMs, m_maxSettleMs;
+
+    void _issue(PokitChar ch);
+    void _onAckTimeout(PokitChar ch);
+};
+
+#endif  // WRITEQUEUE_H